@@ -1,17 +1,34 @@
 ﻿#pragma once
 
 #include <vector>
+#include "RBDSpan.h"
 #include "RBDVariables.h"
 
 namespace VSLibRBDynamX {
 
+    /// 约束的投影类型，求解器据此把约束分桶做批量（非虚）投影
+    enum class RBDProjectionType {
+        BILATERAL,   ///< 等式约束，λ ∈ R，无需投影
+        UNILATERAL,  ///< 单边约束，λ ≥ 0
+        FRICTION_CONE, ///< 3 行摩擦接触 [λn, λt1, λt2]，投影到 ||λt|| ≤ μ λn 的库仑锥
+        CUSTOM       ///< 其它类型，逐个回退到虚函数 Project()
+    };
+
+    /**
+     * 约束关联变量的只读视图（指针 + 长度）
+     *   指向约束自身持有的存储（如 std::array 成员），构造和拷贝都不分配内存，
+     *   多个线程可以同时调用 GetVariables() 并遍历结果。
+     */
+    using RBDVariablesSpan = RBDSpan<RBDVariables* const>;
+
     /// 抽象“约束”类（可实现距离约束、接触、摩擦等）
     class RBDConstraint {
     public:
         virtual ~RBDConstraint() {}
 
-        /// 取得约束关联的变量对象（返回引用或指针，支持多体）
-        virtual const std::vector<RBDVariables*>& GetVariables() const = 0;
+        /// 取得约束关联的变量对象（支持多体）
+        /// 返回指向约束自有存储的视图：不分配内存，可被多个线程并发调用
+        virtual RBDVariablesSpan GetVariables() const = 0;
 
         /// 取得约束维数
         virtual int GetConstraintDim() const = 0;
@@ -26,6 +43,70 @@ namespace VSLibRBDynamX {
         /// 投影操作（如摩擦锥的投影，适用于APGD/PGS等）
         /// 输入输出: lambda 长度等于 GetConstraintDim()
         virtual void Project(std::vector<double>& lambda) const = 0;
+
+        /// 零拷贝投影：lambda 直接指向全局 λ 中本约束的片段（长度 GetConstraintDim()）。
+        /// 默认实现经由 std::vector 版本转发；RBDConstraintN 覆盖为无临时向量的实现。
+        virtual void Project(RBDSpan<double> lambda) const {
+            std::vector<double> tmp(lambda.begin(), lambda.end());
+            Project(tmp);
+            for (std::size_t i = 0; i < lambda.size(); ++i)
+                lambda[i] = tmp[i];
+        }
+
+        /// 投影类型；返回 BILATERAL/UNILATERAL 时求解器不再调用 Project()，
+        /// 而是在同类约束的连续 λ 片段上做批量投影
+        virtual RBDProjectionType GetProjectionType() const { return RBDProjectionType::CUSTOM; }
+
+        /// 摩擦系数 μ（只对 FRICTION_CONE 约束有意义，求解器据此做批量锥投影）
+        virtual double GetFrictionCoefficient() const { return 0.0; }
+
+        /// 柔度（E 块）：约束行变为 D v + E λ + b，E = diag(compliance)，本约束的各行取同一个值。
+        /// compliance = 0（默认）为刚性约束；冗余约束（如闭环关节）给一个小的正柔度后 N + E 正定，
+        /// 迭代数大幅下降，不必再人为加大质量。单位与 N 相同（速度 / 冲量）
+        void SetCompliance(double compliance) {
+            m_compliance = compliance;
+            m_bias_factor = 1.0;
+            MarkDirty();
+        }
+
+        /// 由物理柔度 α = 1/k、阻尼系数 c 与步长 h 设置（隐式弹簧-阻尼，偏置按 φ/h 给出）：
+        /// E = α / (h (h + c α))，偏置乘以 h / (h + c α)。α = 0 时退化为刚性约束。
+        /// 要求 h > 0、α ≥ 0、c ≥ 0，否则不做任何改动并返回 false
+        bool SetComplianceDamping(double compliance, double damping, double h) {
+            if (!(h > 0.0) || !(compliance >= 0.0) || !(damping >= 0.0))
+                return false;
+            const double denom = h + damping * compliance;
+            m_compliance = compliance / (h * denom);
+            m_bias_factor = h / denom;
+            MarkDirty();
+            return true;
+        }
+
+        /// E 块中本约束的对角元
+        double GetCompliance() const { return m_compliance; }
+
+        /// 偏置的缩放系数（刚性约束为 1）；装配时使用 GetBiasFactor() * GetBiasTerm()
+        double GetBiasFactor() const { return m_bias_factor; }
+
+        /// 在全局 λ 中的起始偏移（由系统描述器在 UpdateCountsAndOffsets 中设置）
+        void SetOffset(int offset) { m_offset = offset; }
+        int GetOffset() const { return m_offset; }
+
+        /// 数值版本戳：Jacobian、偏置或摩擦系数改变后调用 MarkDirty()，
+        /// 描述器开启增量更新时只重新装配版本戳变化过的约束（可由不同线程对不同约束并发调用）
+        void MarkDirty() { m_stamp = RBDNextStamp(); }
+        unsigned long long GetStamp() const { return m_stamp; }
+
+        /// 在所属描述器约束容器中的下标（由系统描述器维护，用于 O(1) 移除；-1 表示不在描述器中）
+        void SetIndex(int index) { m_index = index; }
+        int GetIndex() const { return m_index; }
+
+    protected:
+        int m_offset = 0;  ///< 全局 λ 中的偏移
+        int m_index = -1;  ///< 描述器容器中的下标
+        double m_compliance = 0.0;   ///< E 块对角元
+        double m_bias_factor = 1.0;  ///< 偏置缩放系数
+        unsigned long long m_stamp = RBDNextStamp();  ///< 数值版本戳
     };
 
 } // namespace VSLibRBDynamX
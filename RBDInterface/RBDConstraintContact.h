@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include <cmath>
+#include "RBDConstraintN.h"
+
+namespace VSLibRBDynamX {
+
+    /// 把单个接触的 [λn, λt1, λt2] 投影到库仑摩擦锥 ||λt|| ≤ μ λn 上
+    ///   锥内保持不变；落在极锥内（μ||λt|| ≤ -λn）时全部置零；
+    ///   否则投影到锥面：λn' = (μ||λt|| + λn) / (μ² + 1)，||λt'|| = μ λn'。
+    inline void RBDProjectFrictionCone(double mu, double& fn, double& t1, double& t2) {
+        const double ft = std::sqrt(t1 * t1 + t2 * t2);
+        if (ft <= mu * fn && fn >= 0.0)
+            return;
+        if (mu * ft <= -fn) {
+            fn = t1 = t2 = 0.0;
+            return;
+        }
+        const double fn_new = (mu * ft + fn) / (mu * mu + 1.0);
+        const double scale = mu * fn_new / ft;
+        fn = fn_new;
+        t1 *= scale;
+        t2 *= scale;
+    }
+
+    /**
+     * 3 行摩擦接触约束 [法向, 切向 1, 切向 2]
+     *   投影类型为 FRICTION_CONE：求解器把所有接触收集到 λ 的一段连续区间，
+     *   以 4/8 个接触为一组用 SIMD 做锥投影，不再逐个调用 ProjectN()。
+     *   派生类提供 GetVariables / ComputeJacobian / GetBiasTerm（偏置只作用于法向行）。
+     */
+    class RBDConstraintContact : public RBDConstraintN<3> {
+    public:
+        explicit RBDConstraintContact(double mu = 0.0) : m_mu(mu) {}
+
+        void SetFrictionCoefficient(double mu) { m_mu = mu; }
+        double GetFrictionCoefficient() const override { return m_mu; }
+
+        RBDProjectionType GetProjectionType() const override { return RBDProjectionType::FRICTION_CONE; }
+
+        void ProjectN(VectorN& lambda) const override {
+            RBDProjectFrictionCone(m_mu, lambda[0], lambda[1], lambda[2]);
+        }
+
+    protected:
+        double m_mu;  ///< 摩擦系数
+    };
+
+} // namespace VSLibRBDynamX
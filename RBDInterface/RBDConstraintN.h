@@ -0,0 +1,59 @@
+﻿#pragma once
+
+#include <array>
+#include <type_traits>
+#include <vector>
+#include "RBDConstraint.h"
+
+namespace VSLibRBDynamX {
+
+    /**
+     * 固定维数的约束族（Dim 为编译期常量，常用 1/3/6）
+     *   投影在 std::array 上完成，不再为每次投影构造 std::vector。
+     *   动态接口 Project(std::vector<double>&) 与 Project(RBDSpan<double>) 由本类桥接到定长版本。
+     */
+    template <int Dim>
+    class RBDConstraintN : public RBDConstraint {
+    public:
+        static constexpr int FixedDim = Dim;
+        using VectorN = std::array<double, Dim>;
+
+        /// 定长版本的投影（派生类实现）
+        virtual void ProjectN(VectorN& lambda) const = 0;
+
+        // ---- 动态接口桥接 ----
+
+        int GetConstraintDim() const override { return Dim; }
+
+        void Project(std::vector<double>& lambda) const override {
+            VectorN l;
+            for (int i = 0; i < Dim; ++i)
+                l[i] = lambda[i];
+            ProjectN(l);
+            for (int i = 0; i < Dim; ++i)
+                lambda[i] = l[i];
+        }
+
+        void Project(RBDSpan<double> lambda) const override {
+            VectorN l;
+            for (int i = 0; i < Dim; ++i)
+                l[i] = lambda[i];
+            ProjectN(l);
+            for (int i = 0; i < Dim; ++i)
+                lambda[i] = l[i];
+        }
+    };
+
+    using RBDConstraint1 = RBDConstraintN<1>;
+    using RBDConstraint3 = RBDConstraintN<3>;
+    using RBDConstraint6 = RBDConstraintN<6>;
+
+    /// 编译期查询约束类型的固定维数；非 RBDConstraintN 派生类为 0
+    template <class T, class = void>
+    struct RBDConstraintFixedDim : std::integral_constant<int, 0> {};
+
+    template <class T>
+    struct RBDConstraintFixedDim<T, std::void_t<decltype(T::FixedDim)>>
+        : std::integral_constant<int, T::FixedDim> {};
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace VSLibRBDynamX {
+
+    /**
+     * 连续内存的非拥有视图（指针 + 长度），C++17 下 std::span 的最小替代。
+     *   可从任何提供 data()/size() 的连续容器（std::vector、std::array、…）隐式构造，
+     *   也可直接指向全局向量中的一段或宿主引擎的数组，不发生拷贝和分配。
+     */
+    template <class T>
+    class RBDSpan {
+    public:
+        RBDSpan() : m_data(nullptr), m_size(0) {}
+        RBDSpan(T* data, std::size_t size) : m_data(data), m_size(size) {}
+
+        template <class C,
+            class = std::enable_if_t<!std::is_same<std::decay_t<C>, RBDSpan>::value>,
+            class = decltype(static_cast<T*>(std::declval<C&>().data()))>
+        RBDSpan(C& container) : m_data(container.data()), m_size(container.size()) {}
+
+        T* data() const { return m_data; }
+        T* begin() const { return m_data; }
+        T* end() const { return m_data + m_size; }
+        T& operator[](std::size_t i) const { return m_data[i]; }
+        std::size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        /// 子视图 [offset, offset + count)
+        RBDSpan subspan(std::size_t offset, std::size_t count) const { return RBDSpan(m_data + offset, count); }
+
+    private:
+        T* m_data;
+        std::size_t m_size;
+    };
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,15 @@
+﻿#pragma once
+
+#include <atomic>
+
+namespace VSLibRBDynamX {
+
+    /// 进程内唯一、单调递增的版本戳（从 1 开始；0 表示“尚无版本”）。
+    /// 描述器的拓扑版本戳与变量、约束的数值版本戳共用同一个计数器，
+    /// 因此“某个对象在某次装配之后改变过”等价于“它的版本戳大于装配时记下的值”
+    inline unsigned long long RBDNextStamp() {
+        static std::atomic<unsigned long long> counter{ 0 };
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+} // namespace VSLibRBDynamX
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <vector>
+#include "RBDStamp.h"
 #include "RBDVariables.h"
 #include "RBDConstraint.h"
 
@@ -12,20 +13,94 @@ namespace VSLibRBDynamX {
      */
     class RBDSystemDescriptor {
     public:
+        RBDSystemDescriptor() = default;
         virtual ~RBDSystemDescriptor() {}
 
+        /// 拷贝得到的描述器是另一个对象：取新的拓扑版本戳，求解器不会沿用原对象的结构
+        RBDSystemDescriptor(const RBDSystemDescriptor& other)
+            : m_topology_stamp(RBDNextStamp()), m_incremental(other.m_incremental) {}
+        RBDSystemDescriptor& operator=(const RBDSystemDescriptor& other) {
+            MarkTopologyChanged();
+            m_incremental = other.m_incremental;
+            return *this;
+        }
+
         /// 增加一个变量
         virtual void AddVariables(RBDVariables* vars) = 0;
 
         /// 增加一个约束
         virtual void AddConstraint(RBDConstraint* constraint) = 0;
 
+        /// 移除一个约束：与同一容器末尾的约束交换后删除，O(1)，其余约束的相对顺序可能改变。
+        /// 返回是否移除成功；不支持移除的描述器（默认实现）返回 false
+        virtual bool RemoveConstraint(RBDConstraint* /*constraint*/) { return false; }
+
         /// 获取所有变量对象
         virtual const std::vector<RBDVariables*>& GetVariables() const = 0;
 
         /// 获取所有约束对象
         virtual const std::vector<RBDConstraint*>& GetConstraints() const = 0;
 
+        /// 更新变量/约束在全局向量中的偏移，并组装各约束的 Jacobian 块与偏置
+        /// （增删约束或约束数值变化后、求解前必须调用）
+        virtual void UpdateCountsAndOffsets() = 0;
+
+        /// 只刷新数值（Jacobian 块、偏置、摩擦系数、刚体质量），偏移、分桶与邻接表
+        /// 沿用上一次 UpdateCountsAndOffsets 的结果。调用者须保证此后拓扑没有变化
+        /// （GetTopologyStamp() 未变）。默认实现完整重建。
+        /// 开启增量更新时只重新装配数值版本戳变化过的约束与变量。
+        virtual void UpdateValues() { UpdateCountsAndOffsets(); }
+
+        /// 增量更新（默认关闭）：开启后 UpdateValues() 只刷新调用过 MarkDirty() 的约束与变量，
+        /// 宿主须在改变 Jacobian、偏置、摩擦系数或质量后对相应对象调用 MarkDirty()
+        /// （SetCompliance / SetComplianceDamping / SetBodyMass / SetBodyInvInertia 会自动调用）
+        void SetIncrementalUpdate(bool val) { m_incremental = val; }
+        bool IsIncrementalUpdate() const { return m_incremental; }
+
+        /// 拓扑版本戳：增删变量或约束时更新，不同描述器的版本戳也互不相同。
+        /// 求解器记下 Setup 时的版本戳，版本戳不变就跳过结构重建，只调用 UpdateValues()
+        unsigned long long GetTopologyStamp() const { return m_topology_stamp; }
+
+        /// 宿主改变了已有约束的结构（维数、投影类型、关联变量或变量的自由度）时调用，
+        /// 使下一次求解重建结构
+        void MarkTopologyChanged() { m_topology_stamp = RBDNextStamp(); }
+
+        /// 全局 λ 的长度（所有约束维数之和）
+        virtual int CountActiveConstraints() const = 0;
+
+        /// 全局速度向量的长度（所有变量自由度之和）
+        virtual int CountActiveVariables() const = 0;
+
+        /**
+         * Schur 补乘积 result = N * λ，其中 N = D M^{-1} D^T
+         * @param lambda 输入：长度为 CountActiveConstraints() 的乘子向量
+         * @param result 输出：长度为 CountActiveConstraints() 的结果向量
+         */
+        virtual void SchurComplementProduct(const std::vector<double>& lambda,
+            std::vector<double>& result) const = 0;
+
+        /**
+         * 构建 Schur 补右端向量 b（各约束的偏置项），使得 APGD 的梯度为 N*λ + b
+         * @param b 输出：长度为 CountActiveConstraints() 的向量
+         */
+        virtual void BuildBiVector(std::vector<double>& b) const = 0;
+
+        /**
+         * 对全局乘子向量 λ 做投影（λ ← Proj_K(λ)）
+         * @param lambda 输入输出：长度为 CountActiveConstraints() 的向量
+         */
+        virtual void ConstraintsProject(std::vector<double>& lambda) const = 0;
+
+        /**
+         * λ 按投影方式的分段：[0, bilateral_end) 无需投影，[bilateral_end, unilateral_end) 逐元素投影到 λ ≥ 0，
+         * [unilateral_end, n) 只能通过 ConstraintsProject() 投影。求解器据此在融合内核中就地完成前两段的投影。
+         * 默认实现把整个 λ 视为第三段。
+         */
+        virtual void GetProjectionLayout(int& bilateral_end, int& unilateral_end) const {
+            bilateral_end = 0;
+            unilateral_end = 0;
+        }
+
         /**
          * 构建全局系统矩阵 Z 和右端向量 d，使得 Z * x = d
          * @param Z 输出：大小为 n×n 的矩阵（这里用稠密存储，实际可替换为稀疏格式）
@@ -49,10 +124,14 @@ namespace VSLibRBDynamX {
         virtual void BuildDiVector(std::vector<double>& di) const = 0;
 
         /**
-         * 将求解得到的解向量 x = [q; -λ] 写回到各个变量和约束中
-         * @param x 输入：长度为 n 的解向量
+         * 将求解得到的乘子 λ 写回：各变量的状态更新为 v = M^{-1} D^T λ
+         * @param x 输入：长度为 CountActiveConstraints() 的乘子向量
          */
         virtual void SetUnknowns(const std::vector<double>& x) = 0;
+
+    protected:
+        unsigned long long m_topology_stamp = RBDNextStamp();  ///< 拓扑版本戳
+        bool m_incremental = false;  ///< UpdateValues() 是否只刷新版本戳变化的对象
     };
 
 } // namespace VSLibRBDynamX
@@ -1,7 +1,9 @@
 ﻿#pragma once
 
+#include <algorithm>
 #include <vector>
-
+#include "RBDSpan.h"
+#include "RBDStamp.h"
 
 namespace VSLibRBDynamX {
 
@@ -21,6 +23,42 @@ namespace VSLibRBDynamX {
 
         /// 计算 M^{-1} * 力（实现APGD等需要）
         virtual void ComputeMassInverseTimesVector(const std::vector<double>& f, std::vector<double>& result) const = 0;
+
+        // ---- 零拷贝接口：直接读写全局向量（或宿主数组）中属于本变量的片段，长度为 GetDOF() ----
+        // 默认实现经由上面的 std::vector 版本转发（会产生临时向量）；
+        // RBDVariablesN 以及直接映射宿主内存的适配器应覆盖为无拷贝实现。
+
+        /// 把状态写入 x
+        virtual void GetState(RBDSpan<double> x) const {
+            std::vector<double> tmp;
+            GetState(tmp);
+            std::copy(tmp.begin(), tmp.begin() + x.size(), x.begin());
+        }
+
+        /// 从 x 读取状态
+        virtual void SetState(RBDSpan<const double> x) {
+            SetState(std::vector<double>(x.begin(), x.end()));
+        }
+
+        /// result = M^{-1} * f；f 与 result 允许指向同一片段（原地计算）
+        virtual void ComputeMassInverseTimesVector(RBDSpan<const double> f, RBDSpan<double> result) const {
+            std::vector<double> tmp;
+            ComputeMassInverseTimesVector(std::vector<double>(f.begin(), f.end()), tmp);
+            std::copy(tmp.begin(), tmp.begin() + result.size(), result.begin());
+        }
+
+        /// 在全局速度向量中的起始偏移（由系统描述器在 UpdateCountsAndOffsets 中设置）
+        void SetOffset(int offset) { m_offset = offset; }
+        int GetOffset() const { return m_offset; }
+
+        /// 数值版本戳：质量或惯量改变后调用 MarkDirty()，
+        /// 描述器开启增量更新时只重新读取版本戳变化过的变量（可由不同线程对不同变量并发调用）
+        void MarkDirty() { m_stamp = RBDNextStamp(); }
+        unsigned long long GetStamp() const { return m_stamp; }
+
+    protected:
+        int m_offset = 0;  ///< 全局速度向量中的偏移
+        unsigned long long m_stamp = RBDNextStamp();  ///< 数值版本戳
     };
 
 } // namespace VSLibRBDynamX
@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <array>
+#include "RBDVariablesN.h"
+
+namespace VSLibRBDynamX {
+
+    /**
+     * 6 自由度刚体变量：状态为 [v_x, v_y, v_z, ω_x, ω_y, ω_z]
+     *   质量矩阵 M = diag(m, m, m, I_world)，其逆由标量 1/m 和 3×3 世界系惯量逆给出。
+     *   质量逆的计算是 final 的，因此描述器可以把所有刚体收集成 SoA 批量（RBDBodyMassBatch）
+     *   用 SIMD 一次处理，与逐个虚调用的结果逐位相同（批量路径不用 FMA，构建时关闭浮点收缩）。
+     */
+    class RBDVariablesBody : public RBDVariablesN<6> {
+    public:
+        RBDVariablesBody() : m_mass(1.0), m_inv_mass(1.0) {
+            m_inv_inertia = { 1.0, 0.0, 0.0,
+                              0.0, 1.0, 0.0,
+                              0.0, 0.0, 1.0 };
+        }
+
+        /// 设置质量（m ≤ 0 视为固定物体，质量逆为 0），并更新数值版本戳
+        void SetBodyMass(double mass) {
+            m_mass = mass;
+            m_inv_mass = mass > 0 ? 1.0 / mass : 0.0;
+            MarkDirty();
+        }
+        double GetBodyMass() const { return m_mass; }
+        double GetBodyInvMass() const { return m_inv_mass; }
+
+        /// 设置世界系下的惯量张量逆（行主序 3×3，随物体姿态每步更新），并更新数值版本戳
+        void SetBodyInvInertia(const std::array<double, 9>& inv_inertia) {
+            m_inv_inertia = inv_inertia;
+            MarkDirty();
+        }
+        const std::array<double, 9>& GetBodyInvInertia() const { return m_inv_inertia; }
+
+        /// [v; ω] = [f / m; I^{-1} τ]
+        void ComputeMassInverseTimesVectorN(const VectorN& f, VectorN& result) const final {
+            const auto& I = m_inv_inertia;
+            result[0] = m_inv_mass * f[0];
+            result[1] = m_inv_mass * f[1];
+            result[2] = m_inv_mass * f[2];
+            result[3] = I[0] * f[3] + I[1] * f[4] + I[2] * f[5];
+            result[4] = I[3] * f[3] + I[4] * f[4] + I[5] * f[5];
+            result[5] = I[6] * f[3] + I[7] * f[4] + I[8] * f[5];
+        }
+
+    protected:
+        double m_mass;                         ///< 质量
+        double m_inv_mass;                     ///< 质量逆
+        std::array<double, 9> m_inv_inertia;   ///< 世界系惯量逆，行主序
+    };
+
+} // namespace VSLibRBDynamX
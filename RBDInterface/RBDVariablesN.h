@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include <array>
+#include <type_traits>
+#include <vector>
+#include "RBDVariables.h"
+
+namespace VSLibRBDynamX {
+
+    /**
+     * 固定自由度的变量族（DOF 为编译期常量，常用 1/3/6）
+     *   状态保存在 std::array 中，定长接口里的循环长度都是常量，编译器可以完全展开/向量化。
+     *   动态接口（std::vector 版本与零拷贝的 RBDSpan 版本）由本类桥接到定长接口，派生类只需实现定长版本。
+     */
+    template <int DOF>
+    class RBDVariablesN : public RBDVariables {
+    public:
+        static constexpr int FixedDOF = DOF;
+        using VectorN = std::array<double, DOF>;
+
+        RBDVariablesN() { m_state.fill(0.0); }
+
+        /// 定长版本的 M^{-1} * f（派生类实现）
+        virtual void ComputeMassInverseTimesVectorN(const VectorN& f, VectorN& result) const = 0;
+
+        /// 定长版本的状态读写
+        const VectorN& GetStateN() const { return m_state; }
+        void SetStateN(const VectorN& x) { m_state = x; }
+
+        // ---- 动态接口桥接 ----
+
+        int GetDOF() const override { return DOF; }
+
+        void GetState(std::vector<double>& x) const override {
+            x.assign(m_state.begin(), m_state.end());
+        }
+
+        void SetState(const std::vector<double>& x) override {
+            for (int i = 0; i < DOF && i < static_cast<int>(x.size()); ++i)
+                m_state[i] = x[i];
+        }
+
+        void ComputeMassInverseTimesVector(const std::vector<double>& f,
+            std::vector<double>& result) const override {
+            VectorN fn, rn;
+            for (int i = 0; i < DOF; ++i)
+                fn[i] = f[i];
+            ComputeMassInverseTimesVectorN(fn, rn);
+            result.assign(rn.begin(), rn.end());
+        }
+
+        void GetState(RBDSpan<double> x) const override {
+            for (int i = 0; i < DOF; ++i)
+                x[i] = m_state[i];
+        }
+
+        void SetState(RBDSpan<const double> x) override {
+            for (int i = 0; i < DOF; ++i)
+                m_state[i] = x[i];
+        }
+
+        /// 先把 f 读入定长数组再写 result，因此支持原地计算（f 与 result 同址）
+        void ComputeMassInverseTimesVector(RBDSpan<const double> f,
+            RBDSpan<double> result) const override {
+            VectorN fn, rn;
+            for (int i = 0; i < DOF; ++i)
+                fn[i] = f[i];
+            ComputeMassInverseTimesVectorN(fn, rn);
+            for (int i = 0; i < DOF; ++i)
+                result[i] = rn[i];
+        }
+
+    protected:
+        VectorN m_state;  ///< 状态向量（例如速度）
+    };
+
+    using RBDVariables1 = RBDVariablesN<1>;
+    using RBDVariables3 = RBDVariablesN<3>;
+    using RBDVariables6 = RBDVariablesN<6>;
+
+    /// 编译期查询变量类型的固定自由度；非 RBDVariablesN 派生类为 0
+    template <class T, class = void>
+    struct RBDVariablesFixedDOF : std::integral_constant<int, 0> {};
+
+    template <class T>
+    struct RBDVariablesFixedDOF<T, std::void_t<decltype(T::FixedDOF)>>
+        : std::integral_constant<int, T::FixedDOF> {};
+
+} // namespace VSLibRBDynamX
@@ -1,7 +1,8 @@
 ﻿#pragma once
 
-#include "RBDConstraint.h"
+#include "RBDConstraintN.h"
 #include "RBDVariables.h"
+#include <array>
 #include <vector>
 
 namespace VSLibRBDynamX {
@@ -10,29 +11,25 @@ namespace VSLibRBDynamX {
      * MyRBDConstraint
      *   脱离 VEROSIM 的最简实现：
      *   约束形式 C x + b = 0，其中 C = [1, 0, 0, …]，b 可配置
+     *   （定长 RBDConstraintN<1>，动态接口由基类桥接）
      */
-    class MyRBDConstraint : public RBDConstraint {
+    class MyRBDConstraint : public RBDConstraintN<1> {
     public:
         /// @param var  被约束的变量
         /// @param bias 约束偏置 b
         MyRBDConstraint(RBDVariables* var, double bias = 0.0)
-            : m_var(var), m_bias(bias) {}
+            : m_vars{ { var } }, m_bias(bias) {}
 
         ~MyRBDConstraint() override = default;
 
         /// 返回本约束关联的所有变量（这里只有一个）
-        const std::vector<RBDVariables*>& GetVariables() const override {
-            static std::vector<RBDVariables*> tmp;
-            tmp = { m_var };
-            return tmp;
+        RBDVariablesSpan GetVariables() const override {
+            return m_vars;
         }
 
-        /// 约束维度为 1
-        int GetConstraintDim() const override { return 1; }
-
         /// 构造 1×DOF 的 Jacobian，只有第一列为 1
         void ComputeJacobian(std::vector<std::vector<double>>& J) const override {
-            int dof = m_var->GetDOF();
+            int dof = m_vars[0]->GetDOF();
             J.assign(1, std::vector<double>(dof, 0.0));
             J[0][0] = 1.0;
         }
@@ -43,13 +40,18 @@ namespace VSLibRBDynamX {
         }
 
         /// 对 λ 做非负投影
-        void Project(std::vector<double>& lambda) const override {
-            if (!lambda.empty() && lambda[0] < 0.0) lambda[0] = 0.0;
+        void ProjectN(VectorN& lambda) const override {
+            if (lambda[0] < 0.0) lambda[0] = 0.0;
+        }
+
+        /// 单边约束，可走批量投影
+        RBDProjectionType GetProjectionType() const override {
+            return RBDProjectionType::UNILATERAL;
         }
 
     private:
-        RBDVariables* m_var;  ///< 被约束的变量指针
-        double        m_bias; ///< 约束偏置项 b
+        std::array<RBDVariables*, 1> m_vars;  ///< 被约束的变量指针
+        double                       m_bias;  ///< 约束偏置项 b
     };
 
 } // namespace VSLibRBDynamX
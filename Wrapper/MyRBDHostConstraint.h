@@ -0,0 +1,82 @@
+﻿#pragma once
+
+#include "RBDConstraint.h"
+#include "RBDConstraintContact.h"
+#include "RBDVariables.h"
+#include <array>
+#include <vector>
+
+namespace VSLibRBDynamX {
+
+    /**
+     * MyRBDHostConstraint
+     *   直接映射宿主内存的约束适配器：Jacobian 块是宿主的行主序数组
+     *   （dim × 各变量 DOF 之和），本类只保存指针，不拷贝。
+     *   最多关联两个变量；投影类型与摩擦系数由宿主给定。
+     */
+    class MyRBDHostConstraint : public RBDConstraint {
+    public:
+        /// @param var0     第一个变量
+        /// @param var1     第二个变量（可为 nullptr）
+        /// @param dim      约束维数（FRICTION_CONE 为 3）
+        /// @param jacobian 宿主的 Jacobian 块（不拥有）
+        /// @param bias     偏置 b（作用于第一行）
+        /// @param type     投影类型（BILATERAL / UNILATERAL / FRICTION_CONE）
+        /// @param mu       摩擦系数
+        MyRBDHostConstraint(RBDVariables* var0, RBDVariables* var1, int dim, const double* jacobian,
+            double bias, RBDProjectionType type, double mu = 0.0)
+            : m_vars{ { var0, var1 } }, m_num_vars(var1 ? 2 : 1), m_dim(dim), m_jacobian(jacobian),
+              m_bias(bias), m_type(type), m_mu(mu) {}
+
+        RBDVariablesSpan GetVariables() const override {
+            return RBDVariablesSpan(m_vars.data(), m_num_vars);
+        }
+
+        int GetConstraintDim() const override { return m_dim; }
+
+        /// 从宿主数组按行拷出 Jacobian
+        void ComputeJacobian(std::vector<std::vector<double>>& J) const override {
+            int cols = 0;
+            for (int k = 0; k < m_num_vars; ++k)
+                cols += m_vars[k]->GetDOF();
+            J.resize(m_dim);
+            for (int r = 0; r < m_dim; ++r)
+                J[r].assign(m_jacobian + static_cast<std::size_t>(r) * cols,
+                    m_jacobian + static_cast<std::size_t>(r + 1) * cols);
+        }
+
+        double GetBiasTerm() const override { return m_bias; }
+
+        void Project(std::vector<double>& lambda) const override {
+            Project(RBDSpan<double>(lambda));
+        }
+
+        void Project(RBDSpan<double> lambda) const override {
+            switch (m_type) {
+            case RBDProjectionType::UNILATERAL:
+                for (double& l : lambda)
+                    l = l < 0.0 ? 0.0 : l;
+                break;
+            case RBDProjectionType::FRICTION_CONE:
+                RBDProjectFrictionCone(m_mu, lambda[0], lambda[1], lambda[2]);
+                break;
+            default:
+                break;
+            }
+        }
+
+        RBDProjectionType GetProjectionType() const override { return m_type; }
+
+        double GetFrictionCoefficient() const override { return m_mu; }
+
+    private:
+        std::array<RBDVariables*, 2> m_vars;  ///< 关联变量（第二个可为空）
+        int m_num_vars;                       ///< 关联变量个数
+        int m_dim;                            ///< 约束维数
+        const double* m_jacobian;             ///< 宿主 Jacobian 块（不拥有）
+        double m_bias;                        ///< 偏置 b
+        RBDProjectionType m_type;             ///< 投影类型
+        double m_mu;                          ///< 摩擦系数
+    };
+
+} // namespace VSLibRBDynamX
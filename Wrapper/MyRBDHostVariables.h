@@ -0,0 +1,61 @@
+﻿#pragma once
+
+#include "RBDVariables.h"
+#include <vector>
+
+namespace VSLibRBDynamX {
+
+    /**
+     * MyRBDHostVariables
+     *   直接映射宿主引擎内存的变量适配器：状态（速度）与对角质量逆都是宿主数组，
+     *   本类只保存指针，不拷贝。求解器通过零拷贝接口读写时，结果直接落在宿主数组中。
+     */
+    class MyRBDHostVariables : public RBDVariables {
+    public:
+        /// @param state    宿主的状态数组（长度 dof，求解结果写回此处）
+        /// @param inv_mass 宿主的对角质量逆数组（长度 dof）
+        /// @param dof      自由度个数
+        MyRBDHostVariables(double* state, const double* inv_mass, int dof)
+            : m_state(state), m_inv_mass(inv_mass), m_dof(dof) {}
+
+        int GetDOF() const override { return m_dof; }
+
+        // ---- 零拷贝接口：直接读写宿主数组 ----
+
+        void GetState(RBDSpan<double> x) const override {
+            for (int i = 0; i < m_dof; ++i)
+                x[i] = m_state[i];
+        }
+
+        void SetState(RBDSpan<const double> x) override {
+            for (int i = 0; i < m_dof; ++i)
+                m_state[i] = x[i];
+        }
+
+        void ComputeMassInverseTimesVector(RBDSpan<const double> f, RBDSpan<double> result) const override {
+            for (int i = 0; i < m_dof; ++i)
+                result[i] = m_inv_mass[i] * f[i];
+        }
+
+        // ---- std::vector 接口（兼容旧调用方） ----
+
+        void GetState(std::vector<double>& x) const override {
+            x.assign(m_state, m_state + m_dof);
+        }
+
+        void SetState(const std::vector<double>& x) override {
+            SetState(RBDSpan<const double>(x));
+        }
+
+        void ComputeMassInverseTimesVector(const std::vector<double>& f, std::vector<double>& result) const override {
+            result.resize(m_dof);
+            ComputeMassInverseTimesVector(RBDSpan<const double>(f), RBDSpan<double>(result));
+        }
+
+    private:
+        double* m_state;           ///< 宿主状态数组（不拥有）
+        const double* m_inv_mass;  ///< 宿主对角质量逆数组（不拥有）
+        int m_dof;                 ///< 自由度个数
+    };
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,192 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Shared-Memory Solver Protocol
+//
+// RBDShmProtocol.h
+//   本地求解服务（rbd_solver_server）与仿真客户端之间的数据格式。
+//   客户端把一个问题完整写进一段封住大小的共享内存（memfd_create，见 RBDShmSegment.h），
+//   再经 Unix 域套接字发送一条定长的 RBDShmRequest，段的描述符作为 SCM_RIGHTS 附带在这条消息上；
+//   服务端把段映射进自己的地址空间，变量与约束适配器直接指向段内的数组，
+//   求解结果（λ、速度、残差）原地写回同一段，最后回复一条 RBDShmReply。
+//   问题数据本身从不经过套接字，也不在服务端拷贝。
+//
+//   段布局（所有偏移以字节计、从段首算起、按 8 字节对齐）：
+//     RBDShmProblemHeader
+//     int32_t  dof[num_variables]                 各变量的自由度
+//     double   inv_mass[Σdof]                     对角质量逆
+//     double   velocity[Σdof]                     输出：v = M^{-1} D^T λ
+//     RBDShmConstraintRecord constraints[num_constraints]
+//     double   jacobian[jacobian_size]            各约束的 Jacobian 块（行主序）
+//     double   lambda[Σdim]                       输出：按约束顺序排列的 λ
+//
+//   只描述同一台机器上的进程间通信：字节序与对齐按本机，不做序列化。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/socket.h>
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    constexpr std::uint32_t RBD_SHM_MAGIC = 0x53444252u;   ///< "RBDS"
+    constexpr std::uint32_t RBD_SHM_VERSION = 2;
+    constexpr std::size_t RBD_SHM_NAME_MAX = 64;           ///< 段标签（含结尾 '\0'）的最大长度
+
+    /// 问题请求使用的求解器
+    enum RBDShmSolverType : std::int32_t {
+        RBD_SHM_SOLVER_APGD = 0,      ///< 单独用 RBDSolverAPGD 求解
+        RBD_SHM_SOLVER_ENSEMBLE = 1   ///< 同一批中结构与参数相同的问题合并，用 RBDSolverEnsembleAPGD 求解
+    };
+
+    /// 求解状态（RBDShmProblemHeader::status 与 RBDShmReply::status）
+    enum RBDShmStatus : std::int32_t {
+        RBD_SHM_OK = 0,
+        RBD_SHM_PENDING = 1,          ///< 已提交，尚未求解
+        RBD_SHM_BAD_REQUEST = 2,      ///< 请求消息损坏
+        RBD_SHM_BAD_SEGMENT = 3,      ///< 请求未附带段描述符、段大小未封住或无法映射
+        RBD_SHM_BAD_PROBLEM = 4       ///< 段头或布局校验失败
+    };
+
+    /// 约束记录：Jacobian 块为 dim × (dof(var[0]) + dof(var[1])) 的行主序矩阵，
+    /// 从 jacobian[jacobian_index] 开始存放；var[1] < 0 表示单变量约束
+    struct RBDShmConstraintRecord {
+        std::int32_t type;            ///< RBDProjectionType（BILATERAL / UNILATERAL / FRICTION_CONE）
+        std::int32_t dim;             ///< 约束维数（FRICTION_CONE 必须为 3）
+        std::int32_t var[2];          ///< 关联变量的下标
+        double bias;                  ///< 偏置（作用于约束的第一行）
+        double mu;                    ///< 摩擦系数（只对 FRICTION_CONE 有意义）
+        std::uint64_t jacobian_index; ///< Jacobian 块在 jacobian 数组中的起始下标
+    };
+
+    /// 段头：输入字段由客户端填写，输出字段由服务端求解后写回
+    struct RBDShmProblemHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t size;           ///< 段的总字节数
+
+        std::int32_t num_variables;
+        std::int32_t num_constraints;
+        std::int32_t solver;          ///< RBDShmSolverType
+        std::int32_t max_iterations;  ///< ≤ 0 时使用服务端默认值
+        double tolerance;             ///< ≤ 0 时使用服务端默认值
+
+        std::uint64_t total_dof;      ///< Σdof
+        std::uint64_t total_dim;      ///< Σdim（λ 长度）
+        std::uint64_t jacobian_size;  ///< jacobian 数组的元素个数
+
+        std::uint64_t dof_offset;
+        std::uint64_t inv_mass_offset;
+        std::uint64_t velocity_offset;
+        std::uint64_t constraint_offset;
+        std::uint64_t jacobian_offset;
+        std::uint64_t lambda_offset;
+
+        // ---- 输出 ----
+        double residual;
+        std::int32_t iterations;
+        std::int32_t status;          ///< RBDShmStatus
+    };
+
+    /// 客户端 → 服务端：随消息附带的段中的问题已就绪
+    struct RBDShmRequest {
+        std::uint32_t magic;
+        std::uint32_t ticket;         ///< 客户端自选的编号，原样出现在回复中
+        char segment[RBD_SHM_NAME_MAX]; ///< 段标签（只用于诊断，服务端按附带的描述符映射段）
+    };
+
+    /// 服务端 → 客户端：问题 ticket 已求解（λ 已写回段内）或被拒绝
+    struct RBDShmReply {
+        std::uint32_t magic;
+        std::uint32_t ticket;
+        std::int32_t status;          ///< RBDShmStatus
+        std::int32_t iterations;
+        double residual;
+    };
+
+    /// 按各数组的长度填写 header 的计数、偏移与 size（其余字段不变），返回段的总字节数
+    inline std::uint64_t RBDShmComputeLayout(RBDShmProblemHeader& header, int num_variables, int num_constraints,
+        std::uint64_t total_dof, std::uint64_t total_dim, std::uint64_t jacobian_size) {
+        auto align = [](std::uint64_t n) { return (n + 7) & ~std::uint64_t(7); };
+        header.magic = RBD_SHM_MAGIC;
+        header.version = RBD_SHM_VERSION;
+        header.num_variables = num_variables;
+        header.num_constraints = num_constraints;
+        header.total_dof = total_dof;
+        header.total_dim = total_dim;
+        header.jacobian_size = jacobian_size;
+
+        std::uint64_t at = align(sizeof(RBDShmProblemHeader));
+        header.dof_offset = at;
+        at = align(at + sizeof(std::int32_t) * static_cast<std::uint64_t>(num_variables));
+        header.inv_mass_offset = at;
+        at += sizeof(double) * total_dof;
+        header.velocity_offset = at;
+        at += sizeof(double) * total_dof;
+        header.constraint_offset = at;
+        at += sizeof(RBDShmConstraintRecord) * static_cast<std::uint64_t>(num_constraints);
+        header.jacobian_offset = at;
+        at += sizeof(double) * jacobian_size;
+        header.lambda_offset = at;
+        at += sizeof(double) * total_dim;
+        header.size = at;
+        return at;
+    }
+
+    /// 发送一条请求，segment_fd（< 0 表示不附带）作为 SCM_RIGHTS 随消息交给服务端；
+    /// 套接字出错时返回 false
+    inline bool RBDShmSendRequest(int socket_fd, const RBDShmRequest& request, int segment_fd) {
+        const char* p = reinterpret_cast<const char*>(&request);
+        std::size_t left = sizeof(request);
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        bool attach = segment_fd >= 0;
+        while (left > 0) {
+            iovec iov;
+            iov.iov_base = const_cast<char*>(p);
+            iov.iov_len = left;
+            msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            if (attach) {
+                // 描述符挂在第一段数据上；服务端在读到请求的第一个字节时一并收到
+                std::memset(control, 0, sizeof(control));
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
+                cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type = SCM_RIGHTS;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+                std::memcpy(CMSG_DATA(cmsg), &segment_fd, sizeof(int));
+            }
+            const ssize_t n = sendmsg(socket_fd, &msg, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            attach = false;
+            p += n;
+            left -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    /// 段内数组的访问（偏移须已由 RBDShmComputeLayout 或服务端校验）
+    template <class T>
+    inline T* RBDShmArray(RBDShmProblemHeader* header, std::uint64_t offset) {
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(header) + offset);
+    }
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,125 @@
+﻿// =============================================================================
+// VSLibRBDynamX – POSIX Shared-Memory Segment
+//
+// RBDShmSegment.h
+//   一段共享内存（memfd_create + mmap）的 RAII 封装，只可移动。
+//   客户端用 Create() 建段：段的大小在建段时由 F_SEAL_SHRINK | F_SEAL_GROW 封住，
+//   描述符经 Unix 域套接字（SCM_RIGHTS）交给服务端；服务端用 Open() 映射收到的描述符，
+//   映射前用 F_GET_SEALS 确认大小已封住——否则客户端在求解期间 ftruncate 缩小段，
+//   服务端访问被截掉的页时会收到 SIGBUS。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// 映射到本进程的共享内存段
+    class RBDShmSegment {
+    public:
+        /// 服务端要求段上至少有的封印：段的大小不能再改变
+        static constexpr int REQUIRED_SEALS = F_SEAL_SHRINK | F_SEAL_GROW;
+
+        RBDShmSegment() = default;
+        ~RBDShmSegment() { Close(); }
+
+        RBDShmSegment(RBDShmSegment&& other) noexcept { *this = std::move(other); }
+        RBDShmSegment& operator=(RBDShmSegment&& other) noexcept {
+            if (this != &other) {
+                Close();
+                m_name = std::move(other.m_name);
+                m_fd = other.m_fd;
+                m_data = other.m_data;
+                m_size = other.m_size;
+                other.m_fd = -1;
+                other.m_data = nullptr;
+                other.m_size = 0;
+            }
+            return *this;
+        }
+        RBDShmSegment(const RBDShmSegment&) = delete;
+        RBDShmSegment& operator=(const RBDShmSegment&) = delete;
+
+        /// 新建大小为 size 的段并映射，内容为零；大小封住后不能再改变。
+        /// name 只用作 /proc/<pid>/fd 中的标签，不进入任何名字空间
+        bool Create(const std::string& name, std::size_t size) {
+            Close();
+            const int fd = memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+            if (fd < 0)
+                return false;
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0 ||
+                fcntl(fd, F_ADD_SEALS, REQUIRED_SEALS | F_SEAL_SEAL) != 0 || !Map(fd, size)) {
+                close(fd);
+                return false;
+            }
+            m_fd = fd;
+            m_name = name;
+            return true;
+        }
+
+        /// 映射客户端交来的段描述符（接管 fd，无论成败都会关闭它）。
+        /// 段必须带有 REQUIRED_SEALS，大小取段的实际大小
+        bool Open(int fd) {
+            Close();
+            if (fd < 0)
+                return false;
+            struct stat st;
+            const int seals = fcntl(fd, F_GET_SEALS);
+            const bool ok = seals >= 0 && (seals & REQUIRED_SEALS) == REQUIRED_SEALS &&
+                fstat(fd, &st) == 0 && st.st_size > 0 && Map(fd, static_cast<std::size_t>(st.st_size));
+            close(fd);
+            return ok;
+        }
+
+        /// 解除映射并关闭描述符
+        void Close() {
+            if (m_data)
+                munmap(m_data, m_size);
+            if (m_fd >= 0)
+                close(m_fd);
+            m_fd = -1;
+            m_data = nullptr;
+            m_size = 0;
+        }
+
+        void* GetData() const { return m_data; }
+        std::size_t GetSize() const { return m_size; }
+        const std::string& GetName() const { return m_name; }
+
+        /// Create() 建段后保留的描述符（随请求发给服务端）；Open() 映射的段没有
+        int GetFd() const { return m_fd; }
+
+    private:
+        bool Map(int fd, std::size_t size) {
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED)
+                return false;
+            m_data = p;
+            m_size = size;
+            return true;
+        }
+
+        std::string m_name;
+        int m_fd = -1;
+        void* m_data = nullptr;
+        std::size_t m_size = 0;
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,492 @@
+// =============================================================================
+//  RBDSolverServer.cpp
+//
+//  Unix-domain-socket front end that maps sealed client shared-memory segments,
+//  queues the problems and solves them in batches on the global thread pool.
+// =============================================================================
+
+#include "RBDSolverServer.h"
+#include "RBDShmSegment.h"
+#include "RBDSolverAPGD.h"
+#include "RBDSolverEnsembleAPGD.h"
+#include "RBDStaticSystemDescriptor.h"
+#include "RBDThreadPool.h"
+#include "MyRBDHostConstraint.h"
+#include "MyRBDHostVariables.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace VSLibRBDynamX {
+
+    namespace {
+
+        /// 读一条请求及随它附带的段描述符（segment_fd，未附带时为 -1）；对端关闭或出错时返回 false
+        bool ReadRequest(int fd, RBDShmRequest& request, int& segment_fd) {
+            segment_fd = -1;
+            char* p = reinterpret_cast<char*>(&request);
+            std::size_t size = sizeof(request);
+            while (size > 0) {
+                iovec iov;
+                iov.iov_base = p;
+                iov.iov_len = size;
+                alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 4)];
+                msghdr msg;
+                std::memset(&msg, 0, sizeof(msg));
+                msg.msg_iov = &iov;
+                msg.msg_iovlen = 1;
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
+                const ssize_t n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                // 收下所有附带的描述符：只留第一个，其余（以及不属于本请求开头的）立即关闭
+                for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+                    if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS)
+                        continue;
+                    const std::size_t count = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                    for (std::size_t k = 0; k < count; ++k) {
+                        int received;
+                        std::memcpy(&received, CMSG_DATA(c) + k * sizeof(int), sizeof(int));
+                        if (segment_fd < 0 && p == reinterpret_cast<char*>(&request))
+                            segment_fd = received;
+                        else
+                            close(received);
+                    }
+                }
+                if (n <= 0 || (msg.msg_flags & MSG_CTRUNC)) {
+                    if (segment_fd >= 0)
+                        close(segment_fd);
+                    segment_fd = -1;
+                    return false;
+                }
+                p += n;
+                size -= static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+
+        bool WriteFull(int fd, const void* data, std::size_t size) {
+            const char* p = static_cast<const char*>(data);
+            while (size > 0) {
+                const ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                p += n;
+                size -= static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+
+        /// [offset, offset + count * elem) 按 8 字节对齐且落在段内
+        bool RegionFits(std::uint64_t offset, std::uint64_t count, std::uint64_t elem, std::uint64_t size) {
+            if (offset % 8 != 0 || offset > size)
+                return false;
+            return count <= (size - offset) / elem;
+        }
+
+    } // namespace
+
+    struct RBDSolverServer::Connection {
+        explicit Connection(int socket_fd) : fd(socket_fd) {}
+        ~Connection() { close(fd); }
+
+        int fd;
+        std::mutex write_mutex;          ///< 多个求解单元可能同时回复同一连接
+        std::atomic<bool> closed{ false }; ///< 读线程已退出（连接本身在最后一个问题回复后关闭）
+    };
+
+    struct RBDSolverServer::Job {
+        using Descriptor = RBDStaticSystemDescriptor<RBDTypeList<MyRBDHostVariables>,
+            RBDTypeList<MyRBDHostConstraint>>;
+
+        std::shared_ptr<Connection> connection;
+        std::uint32_t ticket = 0;
+        RBDShmSegment segment;
+        RBDShmProblemHeader* header = nullptr;
+        int max_iterations = 0;
+        double tolerance = 0.0;
+
+        // 校验时从段头取出的布局；此后只用这些副本，不再读段头中的偏移与长度
+        std::int32_t solver = RBD_SHM_SOLVER_APGD;
+        double* lambda = nullptr;        ///< 段内 λ 数组（total_dim 个）
+        double* velocity = nullptr;      ///< 段内速度数组（total_dof 个）
+        std::uint64_t total_dof = 0;
+
+        // 适配器只保存指向段内数组的指针；结构（自由度、维数、变量下标）在校验时取出，
+        // 客户端在求解期间改动段内的结构字段不会造成越界
+        std::vector<MyRBDHostVariables> vars;
+        std::vector<MyRBDHostConstraint> cons;
+        Descriptor sysd;
+
+        std::vector<double> key;  ///< 结构与求解参数的签名（ENSEMBLE 分组用）
+    };
+
+    RBDSolverServer::RBDSolverServer() = default;
+
+    RBDSolverServer::~RBDSolverServer() {
+        Stop();
+    }
+
+    bool RBDSolverServer::Start(const std::string& socket_path) {
+        if (m_running)
+            return false;
+
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (socket_path.empty() || socket_path.size() >= sizeof(addr.sun_path))
+            return false;
+        std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+        const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            return false;
+        unlink(socket_path.c_str());
+        // 套接字文件在 bind 时按 umask 创建：只让本用户连接（0600），不留先建后 chmod 的窗口
+        const mode_t old_mask = umask(0177);
+        const bool bound = bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        umask(old_mask);
+        if (!bound || listen(fd, 64) != 0) {
+            close(fd);
+            return false;
+        }
+
+        m_path = socket_path;
+        m_listen_fd = fd;
+        m_stopping = false;
+        m_running = true;
+        m_accept_thread = std::thread([this]() { AcceptLoop(); });
+        m_schedule_thread = std::thread([this]() { ScheduleLoop(); });
+        return true;
+    }
+
+    void RBDSolverServer::Stop() {
+        if (!m_running)
+            return;
+        m_stopping = true;
+
+        // 不再接受新连接，也不再读取新请求
+        shutdown(m_listen_fd, SHUT_RDWR);
+        m_accept_thread.join();
+        {
+            std::lock_guard<std::mutex> lock(m_connections_mutex);
+            for (auto& reader : m_readers)
+                shutdown(reader.connection->fd, SHUT_RD);
+        }
+        // accept 线程已退出，此后没有人再改动 m_readers
+        for (auto& reader : m_readers)
+            reader.thread.join();
+        m_readers.clear();
+
+        // 调度线程求解完已入队的问题后退出
+        m_queue_cv.notify_all();
+        m_schedule_thread.join();
+
+        close(m_listen_fd);
+        m_listen_fd = -1;
+        unlink(m_path.c_str());
+        m_running = false;
+    }
+
+    void RBDSolverServer::AcceptLoop() {
+        while (!m_stopping) {
+            const int fd = accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                break;
+            }
+            // 套接字文件的权限之外再核对对端身份：只服务与本进程同一有效用户的客户端
+            ucred peer;
+            socklen_t peer_len = sizeof(peer);
+            if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &peer_len) != 0 || peer_len != sizeof(peer) ||
+                peer.uid != geteuid()) {
+                close(fd);
+                continue;
+            }
+            auto connection = std::make_shared<Connection>(fd);
+            std::lock_guard<std::mutex> lock(m_connections_mutex);
+            if (m_stopping) {
+                shutdown(fd, SHUT_RDWR);
+                break;
+            }
+            ReapReaders();
+            Reader reader;
+            reader.connection = connection;
+            reader.thread = std::thread([this, connection]() { ReadLoop(connection); });
+            m_readers.push_back(std::move(reader));
+        }
+    }
+
+    void RBDSolverServer::ReapReaders() {
+        // closed 在 ReadLoop 的最后一步置位，此时 join 只需等线程返回
+        auto end = std::remove_if(m_readers.begin(), m_readers.end(), [](Reader& reader) {
+            if (!reader.connection->closed.load())
+                return false;
+            reader.thread.join();
+            return true;
+        });
+        m_readers.erase(end, m_readers.end());
+    }
+
+    void RBDSolverServer::ReadLoop(std::shared_ptr<Connection> connection) {
+        RBDShmRequest request;
+        int segment_fd = -1;
+        while (ReadRequest(connection->fd, request, segment_fd)) {
+            RBDShmStatus status = RBD_SHM_OK;
+            std::unique_ptr<Job> job = MakeJob(request, segment_fd, status);
+            if (!job) {
+                Reply(*connection, request.ticket, status, 0.0, 0);
+                continue;
+            }
+            job->connection = connection;
+            {
+                std::lock_guard<std::mutex> lock(m_queue_mutex);
+                m_queue.push_back(std::move(job));
+            }
+            m_queue_cv.notify_one();
+        }
+        // 读端已关闭：仍在队列中的问题持有连接，回复完后连接才真正关闭
+        connection->closed = true;
+    }
+
+    void RBDSolverServer::ScheduleLoop() {
+        std::vector<std::unique_ptr<Job>> batch;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_queue_mutex);
+                m_queue_cv.wait(lock, [this]() { return !m_queue.empty() || m_stopping; });
+                if (m_queue.empty())
+                    return;
+                // 一次取走所有已就绪的问题（至多 m_max_batch 个）
+                while (!m_queue.empty() && static_cast<int>(batch.size()) < m_max_batch) {
+                    batch.push_back(std::move(m_queue.front()));
+                    m_queue.pop_front();
+                }
+            }
+            SolveBatch(batch);
+            batch.clear();
+        }
+    }
+
+    std::unique_ptr<RBDSolverServer::Job> RBDSolverServer::MakeJob(const RBDShmRequest& request, int segment_fd,
+        RBDShmStatus& status) const {
+        auto job = std::make_unique<Job>();
+        // Open 接管描述符：请求本身无效时也由它关闭
+        const bool opened = job->segment.Open(segment_fd);
+        status = RBD_SHM_BAD_REQUEST;
+        if (request.magic != RBD_SHM_MAGIC)
+            return nullptr;
+        job->ticket = request.ticket;
+        // 段的大小已封住：此后映射内的每一页都一直有效，访问不会 SIGBUS
+        status = RBD_SHM_BAD_SEGMENT;
+        if (!opened || job->segment.GetSize() < sizeof(RBDShmProblemHeader))
+            return nullptr;
+
+        // ---- 段头与布局校验 ----
+        status = RBD_SHM_BAD_PROBLEM;
+        RBDShmProblemHeader* h = static_cast<RBDShmProblemHeader*>(job->segment.GetData());
+        // 段头先整体拷出：校验与之后使用的是同一份值，客户端并发改写段头不影响服务端
+        const RBDShmProblemHeader hd = *h;
+        const std::uint64_t size = job->segment.GetSize();
+        if (hd.magic != RBD_SHM_MAGIC || hd.version != RBD_SHM_VERSION || hd.size > size)
+            return nullptr;
+        const int nv = hd.num_variables;
+        const int nc = hd.num_constraints;
+        if (nv < 0 || nc < 0 ||
+            (hd.solver != RBD_SHM_SOLVER_APGD && hd.solver != RBD_SHM_SOLVER_ENSEMBLE) ||
+            !RegionFits(hd.dof_offset, nv, sizeof(std::int32_t), size) ||
+            !RegionFits(hd.inv_mass_offset, hd.total_dof, sizeof(double), size) ||
+            !RegionFits(hd.velocity_offset, hd.total_dof, sizeof(double), size) ||
+            !RegionFits(hd.constraint_offset, nc, sizeof(RBDShmConstraintRecord), size) ||
+            !RegionFits(hd.jacobian_offset, hd.jacobian_size, sizeof(double), size) ||
+            !RegionFits(hd.lambda_offset, hd.total_dim, sizeof(double), size))
+            return nullptr;
+
+        const std::int32_t* dofs = RBDShmArray<std::int32_t>(h, hd.dof_offset);
+        const RBDShmConstraintRecord* records = RBDShmArray<RBDShmConstraintRecord>(h, hd.constraint_offset);
+        double* inv_mass = RBDShmArray<double>(h, hd.inv_mass_offset);
+        double* velocity = RBDShmArray<double>(h, hd.velocity_offset);
+        const double* jacobian = RBDShmArray<double>(h, hd.jacobian_offset);
+
+        job->header = h;  // 只用于写回输出字段（固定偏移，段不小于段头）
+        job->solver = hd.solver;
+        job->lambda = RBDShmArray<double>(h, hd.lambda_offset);
+        job->velocity = velocity;
+        job->total_dof = hd.total_dof;
+        job->max_iterations = hd.max_iterations > 0 ? hd.max_iterations : m_max_iterations;
+        job->tolerance = hd.tolerance > 0.0 ? hd.tolerance : m_tolerance;
+        auto& key = job->key;
+        key.push_back(job->max_iterations);
+        key.push_back(job->tolerance);
+        key.push_back(nv);
+
+        // 变量：状态指向段内速度数组，质量逆指向段内对角质量逆
+        std::vector<int> var_dof(nv);
+        job->vars.reserve(nv);
+        std::uint64_t at = 0;
+        for (int i = 0; i < nv; ++i) {
+            const int dof = dofs[i];
+            if (dof <= 0 || static_cast<std::uint64_t>(dof) > hd.total_dof - at)
+                return nullptr;
+            var_dof[i] = dof;
+            job->vars.emplace_back(velocity + at, inv_mass + at, dof);
+            at += dof;
+            key.push_back(dof);
+        }
+        if (at != hd.total_dof)
+            return nullptr;
+
+        // 约束：Jacobian 块指向段内数组
+        job->cons.reserve(nc);
+        std::uint64_t rows = 0;
+        for (int i = 0; i < nc; ++i) {
+            const RBDShmConstraintRecord rec = records[i];
+            const auto type = static_cast<RBDProjectionType>(rec.type);
+            if (type != RBDProjectionType::BILATERAL && type != RBDProjectionType::UNILATERAL &&
+                type != RBDProjectionType::FRICTION_CONE)
+                return nullptr;
+            if (rec.dim <= 0 || (type == RBDProjectionType::FRICTION_CONE && rec.dim != 3))
+                return nullptr;
+            if (rec.var[0] < 0 || rec.var[0] >= nv || rec.var[1] >= nv || rec.var[1] == rec.var[0])
+                return nullptr;
+            const bool two = rec.var[1] >= 0;
+            const std::uint64_t cols = var_dof[rec.var[0]] + (two ? var_dof[rec.var[1]] : 0);
+            if (rec.jacobian_index > hd.jacobian_size ||
+                static_cast<std::uint64_t>(rec.dim) * cols > hd.jacobian_size - rec.jacobian_index)
+                return nullptr;
+            job->cons.emplace_back(&job->vars[rec.var[0]], two ? &job->vars[rec.var[1]] : nullptr, rec.dim,
+                jacobian + rec.jacobian_index, rec.bias, type, rec.mu);
+            rows += rec.dim;
+            key.push_back(rec.type);
+            key.push_back(rec.dim);
+            key.push_back(rec.var[0]);
+            key.push_back(rec.var[1] < 0 ? -1 : rec.var[1]);
+        }
+        if (rows != hd.total_dim)
+            return nullptr;
+
+        for (auto& v : job->vars)
+            job->sysd.Add(&v);
+        for (auto& c : job->cons)
+            job->sysd.Add(&c);
+
+        status = RBD_SHM_OK;
+        h->status = RBD_SHM_PENDING;
+        return job;
+    }
+
+    void RBDSolverServer::SolveBatch(std::vector<std::unique_ptr<Job>>& batch) {
+        // 求解单元：APGD 问题各自一个；ENSEMBLE 问题按签名合并
+        std::vector<std::vector<Job*>> units;
+        std::vector<char> ensemble;
+        std::map<std::vector<double>, std::size_t> groups;
+        for (auto& job : batch) {
+            if (job->solver == RBD_SHM_SOLVER_ENSEMBLE) {
+                auto it = groups.emplace(job->key, units.size());
+                if (it.second) {
+                    units.emplace_back();
+                    ensemble.push_back(1);
+                }
+                units[it.first->second].push_back(job.get());
+            } else {
+                units.emplace_back(1, job.get());
+                ensemble.push_back(0);
+            }
+        }
+
+        const std::size_t num_units = units.size();
+        if (m_apgd.size() < num_units)
+            m_apgd.resize(num_units);
+        if (m_ensemble.size() < num_units)
+            m_ensemble.resize(num_units);
+        for (std::size_t u = 0; u < num_units; ++u) {
+            if (ensemble[u] && !m_ensemble[u])
+                m_ensemble[u] = std::make_unique<RBDSolverEnsembleAPGD>();
+            else if (!ensemble[u] && !m_apgd[u])
+                m_apgd[u] = std::make_unique<RBDSolverAPGD>();
+        }
+
+        RBDGetThreadPool().ParallelFor(0, static_cast<int>(num_units), 1, [&](int begin, int end) {
+            for (int u = begin; u < end; ++u) {
+                if (ensemble[u])
+                    SolveEnsemble(units[u], *m_ensemble[u]);
+                else
+                    SolveSingle(*units[u][0], *m_apgd[u]);
+            }
+        });
+
+        m_num_solved += static_cast<long long>(batch.size());
+        ++m_num_batches;
+    }
+
+    void RBDSolverServer::SolveSingle(Job& job, RBDSolverAPGD& solver) const {
+        solver.SetMaxIterations(job.max_iterations);
+        solver.SetTolerance(job.tolerance);
+        const double residual = solver.SolveSpecialized(job.sysd);
+        std::vector<double> lambda;
+        solver.Dump_Lambda(lambda);
+        Finish(job, lambda, residual, solver.GetIterations());
+    }
+
+    void RBDSolverServer::SolveEnsemble(const std::vector<Job*>& jobs, RBDSolverEnsembleAPGD& solver) const {
+        solver.SetMaxIterations(jobs[0]->max_iterations);
+        solver.SetTolerance(jobs[0]->tolerance);
+        std::vector<RBDSystemDescriptor*> scenes(jobs.size());
+        for (std::size_t s = 0; s < jobs.size(); ++s)
+            scenes[s] = &jobs[s]->sysd;
+        solver.Solve(scenes);
+
+        std::vector<double> lambda;
+        for (std::size_t s = 0; s < jobs.size(); ++s) {
+            solver.Dump_Lambda(static_cast<int>(s), lambda);
+            Finish(*jobs[s], lambda, solver.GetResidual(static_cast<int>(s)),
+                solver.GetIterations(static_cast<int>(s)));
+        }
+    }
+
+    void RBDSolverServer::Finish(Job& job, const std::vector<double>& lambda, double residual,
+        int iterations) const {
+        RBDShmProblemHeader* h = job.header;
+
+        // λ 从描述器布局换回客户端的约束顺序（只用校验时保存的位置与长度）
+        double* out = job.lambda;
+        for (const auto& c : job.cons) {
+            const int dim = c.GetConstraintDim();
+            std::copy(lambda.begin() + c.GetOffset(), lambda.begin() + c.GetOffset() + dim, out);
+            out += dim;
+        }
+        // 没有约束时不会调用 SetUnknowns，速度为零
+        if (lambda.empty())
+            std::fill_n(job.velocity, job.total_dof, 0.0);
+
+        h->residual = residual;
+        h->iterations = iterations;
+        h->status = RBD_SHM_OK;
+        job.segment.Close();
+        Reply(*job.connection, job.ticket, RBD_SHM_OK, residual, iterations);
+    }
+
+    void RBDSolverServer::Reply(Connection& connection, std::uint32_t ticket, RBDShmStatus status,
+        double residual, int iterations) {
+        RBDShmReply reply;
+        reply.magic = RBD_SHM_MAGIC;
+        reply.ticket = ticket;
+        reply.status = status;
+        reply.iterations = iterations;
+        reply.residual = residual;
+        std::lock_guard<std::mutex> lock(connection.write_mutex);
+        WriteFull(connection.fd, &reply, sizeof(reply));
+    }
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,131 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Local Multi-Client Solver Server
+//
+// RBDSolverServer.h
+//   在 Unix 域套接字上接受多个仿真客户端的求解请求（协议见 RBDShmProtocol.h）。
+//   只接受与服务进程同一有效用户的连接（套接字文件 0600，并核对 SO_PEERCRED）。
+//   每个连接一个读线程：收到请求后映射随请求附带的共享内存段（大小须已封住）、校验布局，
+//   用 MyRBDHostVariables / MyRBDHostConstraint 直接指向段内数组建好描述器，放入队列。
+//   调度线程每次取走队列中所有已就绪的问题作为一批：
+//     - RBD_SHM_SOLVER_APGD 的问题各自用一个 RBDSolverAPGD 求解；
+//     - RBD_SHM_SOLVER_ENSEMBLE 的问题按结构与求解参数分组，每组交给一个 RBDSolverEnsembleAPGD；
+//   各求解单元在 RBDGetThreadPool() 上并行执行，λ、速度与残差原地写回段内后立即回复对应客户端。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RBDShmProtocol.h"
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    class RBDSolverAPGD;
+    class RBDSolverEnsembleAPGD;
+
+    /// 共享内存 + Unix 域套接字的本地求解服务
+    class RBDSolverServer {
+    public:
+        RBDSolverServer();
+        ~RBDSolverServer();
+
+        RBDSolverServer(const RBDSolverServer&) = delete;
+        RBDSolverServer& operator=(const RBDSolverServer&) = delete;
+
+        /// 在 socket_path 上监听并启动各线程（已存在的同名套接字文件会被替换），失败返回 false
+        bool Start(const std::string& socket_path);
+
+        /// 停止接受连接，求解完已入队的问题后退出各线程并删除套接字文件
+        void Stop();
+
+        bool IsRunning() const { return m_running; }
+
+        /// 问题头中 max_iterations / tolerance ≤ 0 时使用的默认值（须在 Start 之前设置）
+        void SetMaxIterations(int max_iter) { m_max_iterations = max_iter; }
+        int GetMaxIterations() const { return m_max_iterations; }
+        void SetTolerance(double tol) { m_tolerance = tol; }
+        double GetTolerance() const { return m_tolerance; }
+
+        /// 每批最多取出的问题数（默认 256）
+        void SetMaxBatchSize(int n) { m_max_batch = n < 1 ? 1 : n; }
+        int GetMaxBatchSize() const { return m_max_batch; }
+
+        /// 统计：已求解的问题数与批数
+        long long GetNumSolved() const { return m_num_solved.load(); }
+        long long GetNumBatches() const { return m_num_batches.load(); }
+
+    private:
+        struct Connection;
+        struct Job;
+
+        /// 一个连接及其读线程；连接关闭后由 AcceptLoop 回收
+        struct Reader {
+            std::shared_ptr<Connection> connection;
+            std::thread thread;
+        };
+
+        /// join 并移除已结束的读线程（须持有 m_connections_mutex）
+        void ReapReaders();
+
+        void AcceptLoop();
+        void ReadLoop(std::shared_ptr<Connection> connection);
+        void ScheduleLoop();
+
+        /// 映射随请求附带的段（接管 segment_fd）并建好描述器；失败时返回空并在 status 中给出原因
+        std::unique_ptr<Job> MakeJob(const RBDShmRequest& request, int segment_fd, RBDShmStatus& status) const;
+
+        /// 求解一批问题并逐个回复
+        void SolveBatch(std::vector<std::unique_ptr<Job>>& batch);
+        void SolveSingle(Job& job, RBDSolverAPGD& solver) const;
+        void SolveEnsemble(const std::vector<Job*>& jobs, RBDSolverEnsembleAPGD& solver) const;
+
+        /// 按约束顺序把 λ 写进段内，填写输出字段并回复客户端
+        void Finish(Job& job, const std::vector<double>& lambda, double residual, int iterations) const;
+
+        static void Reply(Connection& connection, std::uint32_t ticket, RBDShmStatus status,
+            double residual, int iterations);
+
+        std::string m_path;
+        int m_listen_fd = -1;
+        std::atomic<bool> m_running{ false };
+        std::atomic<bool> m_stopping{ false };
+
+        int m_max_iterations = 1000;
+        double m_tolerance = 1e-6;
+        int m_max_batch = 256;
+
+        std::thread m_accept_thread;
+        std::thread m_schedule_thread;
+
+        std::mutex m_connections_mutex;
+        std::vector<Reader> m_readers;  ///< 仍在读取的连接（已关闭的在下一次 accept 时回收）
+
+        std::mutex m_queue_mutex;
+        std::condition_variable m_queue_cv;
+        std::deque<std::unique_ptr<Job>> m_queue;
+
+        // 各求解单元的求解器（只由调度线程使用，跨批复用工作区）
+        std::vector<std::unique_ptr<RBDSolverAPGD>> m_apgd;
+        std::vector<std::unique_ptr<RBDSolverEnsembleAPGD>> m_ensemble;
+
+        std::atomic<long long> m_num_solved{ 0 };
+        std::atomic<long long> m_num_batches{ 0 };
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,69 @@
+﻿// =============================================================================
+//  rbd_solver_server.cpp
+//
+//  本地求解服务进程：
+//    rbd_solver_server [socket_path] [--threads N] [--max-iterations N] [--tolerance T] [--max-batch N]
+//  在 socket_path（默认 /tmp/rbd_solver.sock）上等待客户端，收到 SIGINT / SIGTERM 后
+//  求解完已入队的问题并退出。协议见 RBDShmProtocol.h。
+// =============================================================================
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <pthread.h>
+
+#include "RBDSolverServer.h"
+#include "RBDThreadPool.h"
+
+using namespace VSLibRBDynamX;
+
+int main(int argc, char** argv) {
+    // 在启动任何线程（包括线程池）之前屏蔽信号，由主线程同步等待
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    std::string path = "/tmp/rbd_solver.sock";
+    RBDSolverServer server;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--threads" && has_value) {
+            RBDGetThreadPool().SetNumThreads(std::atoi(argv[++i]));
+        } else if (arg == "--max-iterations" && has_value) {
+            server.SetMaxIterations(std::atoi(argv[++i]));
+        } else if (arg == "--tolerance" && has_value) {
+            server.SetTolerance(std::atof(argv[++i]));
+        } else if (arg == "--max-batch" && has_value) {
+            server.SetMaxBatchSize(std::atoi(argv[++i]));
+        } else if (!arg.empty() && arg[0] != '-') {
+            path = arg;
+        } else {
+            std::cerr << "usage: " << argv[0]
+                      << " [socket_path] [--threads N] [--max-iterations N] [--tolerance T] [--max-batch N]\n";
+            return 2;
+        }
+    }
+
+    if (!server.Start(path)) {
+        std::cerr << "rbd_solver_server: cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::cout << "rbd_solver_server: listening on " << path << " with "
+              << RBDGetThreadPool().GetNumThreads() << " threads" << std::endl;
+
+    int sig = 0;
+    sigwait(&signals, &sig);
+
+    server.Stop();
+    std::cout << "rbd_solver_server: solved " << server.GetNumSolved() << " problems in "
+              << server.GetNumBatches() << " batches" << std::endl;
+    return 0;
+}
@@ -0,0 +1,63 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Batched Rigid-Body Mass Inverse
+//
+// RBDBodyMassBatch.h
+//   把所有 6 自由度刚体（RBDVariablesBody）的质量逆参数收集成 SoA 布局，
+//   一次性对全局速度向量中的所有刚体片段原地计算 M^{-1} f。
+//   - 参数（1/m 与 9 个惯量逆分量）各自连续存放，4/8 个刚体一组用 AVX2/AVX-512 计算；
+//   - 指令集在运行时按 RBDGetSimdLevel() 选择，无 AVX 的机器走标量路径；
+//     各路径都不用 FMA、运算顺序相同，结果与逐个虚调用逐位相同（与级别无关）；
+//   - 速度片段按固定大小的包 gather 到栈上的 6 个分量数组，计算后 scatter 回去，
+//     因为刚体在全局向量中的偏移不一定连续。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "RBDVariablesBody.h"
+#include "RBDSimd.h"
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// 刚体质量逆的 SoA 批量
+    class RBDBodyMassBatch {
+    public:
+        /// 清空（每次 UpdateCountsAndOffsets 重新收集）
+        void Clear();
+
+        /// 登记一个刚体：读取它当前的偏移、质量逆和世界系惯量逆
+        void Add(const RBDVariablesBody* body);
+
+        /// 重新读取登记刚体的质量逆和世界系惯量逆（刚体集合与偏移不变时代替 Clear + Add）。
+        /// incremental 为 true 时只读取版本戳在上次读取之后变化过的刚体
+        void UpdateValues(bool incremental = false);
+
+        int GetNumBodies() const { return static_cast<int>(m_offset.size()); }
+
+        /// 对所有登记刚体原地计算 v[off .. off+6) = M^{-1} v[off .. off+6)（按刚体分块并行）。
+        /// gather 缓冲在栈上，不修改成员，可以同时对不同的 v 调用
+        void Apply(double* v) const;
+
+    private:
+        /// 刚体 [begin, end) 的 M^{-1}
+        void ApplyRange(int begin, int end, RBDSimdLevel level, double* v) const;
+
+        std::vector<const RBDVariablesBody*> m_bodies;  ///< 登记的刚体
+        std::vector<unsigned long long> m_stamps;       ///< 上次读取时刚体的数值版本戳
+        std::vector<int> m_offset;                      ///< 刚体在全局速度向量中的偏移
+        std::vector<double> m_inv_mass;                 ///< 1/m
+        std::array<std::vector<double>, 9> m_inv_inertia; ///< 惯量逆的 9 个分量，各自连续
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,191 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Constraint Batch Store
+//
+// RBDConstraintBatches.h
+//   按投影类型把约束分桶，并为每个约束分配其在全局 λ 中的偏移。
+//   同一类型的约束在 λ 中占据一段连续区间，投影时每个桶只需一个
+//   非虚、可向量化的循环，不再逐约束调用 RBDConstraint::Project()。
+//
+//   同时保存每个约束的 Jacobian 块（行主序、扁平存储）与偏置，
+//   Schur 补乘积中的 D*v 与 D^T*λ 直接在这些块上完成；柔性约束的 E 块按 λ 布局
+//   存成对角向量，由 AddComplianceProduct 加到 D*v 上。
+//
+//   D^T*λ 会向多个约束共享的变量累加，并行时有写冲突。两种无冲突实现：
+//   - GATHER：Assemble 时建好 变量 -> 约束槽 的邻接表（CSR 转置），
+//     每个变量按固定顺序收集自己的贡献，按变量并行；
+//   - ACCUMULATE：约束按固定分块各自散射到私有累加向量，再按块序号归约，
+//     适合少数变量（如地面、大型刚体）被大量约束共享、GATHER 负载严重不均的情形。
+//   两种方式的求和顺序都只由问题结构决定，结果与线程数无关（逐位一致）。
+//
+//   Assemble 分两步：AssembleStructure 排好变量槽、各 Jacobian 块的位置与 CSR 转置，
+//   只依赖拓扑；AssembleValues 在 RBDGetThreadPool() 上按约束并行调用
+//   ComputeJacobian / GetBiasTerm 直接写入各自的位置，因此这两个函数必须可以被
+//   不同线程同时调用（只读约束自身状态）。拓扑不变时只需重做 AssembleValues；
+//   增量模式下只重新装配数值版本戳（RBDConstraint::GetStamp）变化过的约束。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "RBDConstraint.h"
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// D^T*λ 的并行累加方式
+    enum class RBDTransposeMode {
+        AUTO,        ///< Assemble 时按问题形状自动选择
+        GATHER,      ///< 按变量收集（CSR 转置）
+        ACCUMULATE   ///< 分块私有累加 + 归约
+    };
+
+    /// 并行装配中单个线程的统计
+    struct RBDAssemblyThreadStats {
+        int constraints = 0;             ///< 装配的约束数
+        long long jacobian_entries = 0;  ///< 写入的 Jacobian 元素数
+        double seconds = 0.0;            ///< 在装配上花费的时间
+    };
+
+    /// 约束批量存储：全局 λ 布局 + 按类型分桶的批量投影 + Jacobian 块。
+    ///
+    /// λ 的布局为 [BILATERAL | UNILATERAL | FRICTION_CONE | CUSTOM]，每段内部保持约束的添加顺序。
+    class RBDConstraintBatches {
+    public:
+        RBDConstraintBatches()
+            : m_num_rows(0), m_num_dofs(0), m_acc_blocks(1),
+              m_transpose_mode(RBDTransposeMode::AUTO), m_active_mode(RBDTransposeMode::GATHER) {}
+
+        /// 根据约束列表重建分桶和偏移，并写回各约束的 SetOffset()（约束集合变化后调用）
+        void Setup(const std::vector<RBDConstraint*>& cons);
+
+        /// 从约束中取出 Jacobian 块和偏置（需先 Setup，且变量偏移已设置），按约束并行。
+        /// 等价于 AssembleStructure + AssembleValues
+        void Assemble(const std::vector<RBDConstraint*>& cons);
+
+        /// 只依赖拓扑的部分：变量槽、Jacobian 块的位置、D^T λ 的 CSR 转置与累加方式
+        void AssembleStructure(const std::vector<RBDConstraint*>& cons);
+
+        /// 只刷新数值：Jacobian 块、偏置与摩擦系数（约束列表与拓扑须与上一次 AssembleStructure 相同）。
+        /// incremental 为 true 时跳过版本戳与上次装配时相同的约束
+        void AssembleValues(const std::vector<RBDConstraint*>& cons, bool incremental = false);
+
+        /// 最近一次 Assemble / AssembleValues 实际重新装配的约束数
+        int GetNumAssembled() const { return m_num_assembled; }
+
+        /// 最近一次 Assemble 的逐线程统计，下标为 RBDThreadPool::GetThreadIndex()
+        /// （0 号汇总了所有非线程池线程，包括调用线程）
+        const std::vector<RBDAssemblyThreadStats>& GetAssemblyStats() const { return m_assembly_stats; }
+
+        /// 最近一次 Assemble / AssembleValues 的总耗时（Assemble 含串行的槽布局与 CSR 转置）
+        double GetAssemblySeconds() const { return m_assembly_seconds; }
+
+        /// 全局 λ 的长度
+        int GetNumRows() const { return m_num_rows; }
+
+        /// 第 i 个约束（按添加顺序）在全局 λ 中的起始偏移
+        int GetOffset(std::size_t i) const { return m_offsets[i]; }
+
+        /// 某一投影类型在 λ 中的连续区间 [begin, end)
+        int GetBegin(RBDProjectionType type) const { return m_begin[static_cast<int>(type)]; }
+        int GetEnd(RBDProjectionType type) const { return m_begin[static_cast<int>(type) + 1]; }
+
+        /// 对全局 λ 做批量投影
+        void Project(std::vector<double>& lambda) const;
+
+        /// 只投影 BILATERAL/UNILATERAL/FRICTION_CONE 桶（CUSTOM 段留给调用者处理）
+        void ProjectBatched(double* lambda) const;
+
+        /// v += D^T * λ，v 的长度为全局速度向量长度（并行，结果与线程数无关）。
+        /// scratch 是 ACCUMULATE 方式的私有累加向量 [块][自由度]，由调用者持有（GATHER 方式不使用）：
+        /// 本对象在调用中不写任何成员，使用不同 scratch 的调用可以同时进行
+        void MultiplyTranspose(const double* lambda, double* v, std::vector<double>& scratch) const;
+
+        /// 指定 D^T*λ 的累加方式（下一次 Assemble 起生效）
+        void SetTransposeMode(RBDTransposeMode mode) { m_transpose_mode = mode; }
+        RBDTransposeMode GetTransposeMode() const { return m_transpose_mode; }
+
+        /// 当前实际使用的方式（AUTO 解析后的结果）
+        RBDTransposeMode GetActiveTransposeMode() const { return m_active_mode; }
+
+        /// out = D * v，out 的长度为 GetNumRows()（按约束在 RBDGetThreadPool() 上并行）
+        void Multiply(const double* v, double* out) const;
+
+        /// out += E * λ（E 为柔度对角阵，没有柔性约束时直接返回）
+        void AddComplianceProduct(const double* lambda, double* out) const;
+
+        /// 是否有柔度非零的约束
+        bool HasCompliance() const { return m_has_compliance; }
+
+        /// E 的对角元，按 λ 布局排列
+        const std::vector<double>& GetCompliance() const { return m_compliance; }
+
+        /// b = 各约束偏置（偏置放在每个约束的第一行，其余行为 0）
+        void BuildBiVector(std::vector<double>& b) const;
+
+    private:
+        /// 约束 [begin, end) 的 out = D * v
+        void MultiplyRange(int begin, int end, const double* v, double* out) const;
+
+        /// 约束 [begin, end) 的变量槽
+        void StructureRange(const std::vector<RBDConstraint*>& cons, int begin, int end);
+
+        /// 约束 [begin, end) 的 Jacobian 块、偏置与摩擦系数（incremental 时跳过版本戳未变的约束），
+        /// 返回这一段的统计
+        RBDAssemblyThreadStats AssembleRange(const std::vector<RBDConstraint*>& cons, int begin, int end,
+            bool incremental);
+
+        /// 约束 [begin, end) 的 v += D^T * λ（串行散射）
+        void ScatterRange(int begin, int end, const double* lambda, double* v) const;
+
+        /// 变量 [begin, end) 的 v += D^T * λ（按 CSR 转置收集）
+        void GatherRange(int begin, int end, const double* lambda, double* v) const;
+
+        /// 建立变量 -> 约束槽邻接表，并按问题形状确定累加方式与分块数
+        void BuildTranspose();
+
+        static const int NUM_TYPES = static_cast<int>(RBDProjectionType::CUSTOM) + 1;
+
+        int m_num_rows;                              ///< λ 总长度
+        int m_begin[NUM_TYPES + 1] = {};             ///< 各类型区间起点（最后一项为总长度）
+        std::vector<int> m_offsets;                  ///< 每个约束的 λ 偏移
+        std::vector<int> m_dims;                     ///< 每个约束的维数
+        std::vector<const RBDConstraint*> m_custom;  ///< CUSTOM 桶中的约束（需要虚函数投影）
+        std::vector<int> m_custom_offsets;           ///< CUSTOM 约束的 λ 偏移
+        std::vector<double> m_cone_mu;               ///< FRICTION_CONE 段内各接触的摩擦系数
+
+        std::vector<int> m_jac_begin;                ///< 每个约束的 Jacobian 块在 m_jac 中的起点（长度 n+1）
+        std::vector<double> m_jac;                   ///< 所有 Jacobian 块，行主序扁平存储
+        std::vector<int> m_slot_begin;               ///< 每个约束的变量槽在 m_slot_* 中的起点（长度 n+1）
+        std::vector<int> m_slot_offset;              ///< 变量槽：变量在全局速度向量中的偏移
+        std::vector<int> m_slot_dof;                 ///< 变量槽：变量自由度
+        std::vector<int> m_slot_con;                 ///< 变量槽：所属约束
+        std::vector<int> m_slot_col;                 ///< 变量槽：在 Jacobian 行中的起始列
+        std::vector<double> m_bias;                  ///< 按 λ 布局排列的偏置
+        std::vector<unsigned long long> m_stamps;    ///< 每个约束上次装配时的数值版本戳（0 表示未装配）
+        std::vector<double> m_compliance;            ///< 按 λ 布局排列的 E 对角元
+        bool m_has_compliance = false;               ///< m_compliance 是否有非零元
+
+        std::vector<int> m_var_offset;               ///< CSR 转置：各变量在全局速度向量中的偏移
+        std::vector<int> m_var_dof;                  ///< CSR 转置：各变量自由度
+        std::vector<int> m_var_begin;                ///< CSR 转置：各变量的槽列表起点（长度 nv+1）
+        std::vector<int> m_var_slots;                ///< CSR 转置：槽下标，按约束顺序排列
+        int m_num_dofs;                              ///< 被约束涉及的速度向量长度上界
+        int m_acc_blocks;                            ///< ACCUMULATE 的约束分块数（与线程数无关）
+        RBDTransposeMode m_transpose_mode;           ///< 用户指定的方式
+        RBDTransposeMode m_active_mode;              ///< 实际使用的方式
+
+        std::vector<RBDAssemblyThreadStats> m_assembly_stats;  ///< 逐线程装配统计
+        double m_assembly_seconds = 0.0;             ///< 最近一次装配总耗时
+        int m_num_assembled = 0;                     ///< 最近一次实际装配的约束数
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,82 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Ensemble Schur Complement Operator
+//
+// RBDEnsembleSchur.h
+//   S 个结构完全相同（约束数、维数、投影类型、变量偏移一致，只有数值不同）的
+//   描述器的 Schur 补算子，所有向量按 [行][场景] 交错存放：
+//     λ[i * S + s]、v[j * S + s]、D[e * S + s]、M^{-1}D^T[e * S + s]。
+//   结构只存一份：D 按行、M^{-1}D^T 按速度分量各存成一个 CSR，
+//   两次 RBDVectorKernels::LaneCsrMultiply 沿场景方向向量化，一次遍历完成 S 个小问题。
+//   每个通道（场景列）可以单独用 SetupLane 换成另一个同结构的描述器。
+//
+//   FRICTION_CONE 行天然是 [n][场景]、[t1][场景]、[t2][场景] 的 SoA，
+//   直接交给 RBDVectorKernels::ProjectFrictionCone（各场景摩擦系数可不同）。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <vector>
+#include "RBDSystemDescriptor.h"
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// [行][场景] 交错布局的多场景 N = D M^{-1} D^T 算子
+    class RBDEnsembleSchur {
+    public:
+        /// 以 sysd（须已调用 UpdateCountsAndOffsets）的结构建立 num_scenes 个通道，数值清零
+        void SetupStructure(const RBDSystemDescriptor& sysd, int num_scenes);
+
+        /// 把通道 s 的数值换成 sysd 的（结构须与 SetupStructure 时一致）
+        void SetupLane(int s, const RBDSystemDescriptor& sysd);
+
+        /// 场景数 S
+        int GetNumScenes() const { return m_num_scenes; }
+
+        /// 每个场景的 λ 长度
+        int CountActiveConstraints() const { return m_num_rows; }
+
+        /// result = D * (M^{-1}D^T * λ) + E * λ，λ 与 result 长度为 行数 * S
+        void SchurComplementProduct(const std::vector<double>& lambda, std::vector<double>& result) const;
+
+        /// 各场景的 λ ← Proj_K(λ)
+        void ConstraintsProject(std::vector<double>& lambda) const;
+
+        /// b = 各场景偏置（交错布局）
+        void BuildBiVector(std::vector<double>& b) const { b = m_bias; }
+
+    private:
+        int m_num_scenes = 0;
+        int m_num_rows = 0;
+        int m_num_dofs = 0;
+        std::vector<int> m_entry_row;                   ///< 各 Jacobian 元素的行（λ 下标），按 ComputeJacobian 顺序
+        std::vector<int> m_entry_col;                   ///< 各 Jacobian 元素的列（速度分量下标）
+        std::vector<int> m_d_ptr, m_d_col, m_d_pos;     ///< D 的 CSR（按行）及元素 e 在其中的位置
+        std::vector<int> m_t_ptr, m_t_row, m_t_pos;     ///< M^{-1}D^T 的 CSR（按速度分量）及元素 e 的位置
+        std::vector<RBDProjectionType> m_types;         ///< 各约束的投影类型（结构校验用）
+        std::vector<double> m_jac;                      ///< D [CSR 元素][场景]
+        std::vector<double> m_eq;                       ///< M^{-1}D^T [CSR 元素][场景]
+        std::vector<double> m_bias;                     ///< 偏置 [行][场景]
+        std::vector<double> m_compliance;               ///< E 的对角元 [行][场景]（全为 0 时为空）
+        std::vector<int> m_unilateral;                  ///< λ ≥ 0 的行区间，成对存放 [begin, end)
+        std::vector<int> m_cone_offsets;                ///< FRICTION_CONE 约束的行偏移
+        std::vector<double> m_cone_mu;                  ///< 摩擦系数 [接触][场景]
+        std::vector<int> m_custom_offsets;              ///< CUSTOM 约束的行偏移
+        std::vector<int> m_custom_dims;                 ///< CUSTOM 约束的维数
+        std::vector<const RBDConstraint*> m_custom;     ///< CUSTOM 约束 [约束][场景]
+
+        std::vector<std::vector<double>> m_J;           ///< SetupLane 的 Jacobian 缓冲
+        std::vector<double> m_mf;                       ///< SetupLane 的质量逆缓冲
+        mutable std::vector<double> m_v;                ///< 速度累加缓冲 [自由度][场景]
+        mutable std::vector<double> m_scratch;          ///< CUSTOM 投影的单场景片段
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
@@ -11,6 +11,7 @@
 //   - 收敛历史记录
 //   - Over-relaxation 与 Sharpness 参数
 //   - AtIterationEnd 用于记录每轮残差与乘子变化
+//   - 时间预算：按单调时钟限时求解，并用每轮耗时统计收紧下一步的迭代上限
 //
 // Copyright (c) 2025 Zijian Zhang
 // All rights reserved.
@@ -21,6 +22,8 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <vector>
 #include "RBDSystemDescriptor.h"
 
@@ -62,16 +65,112 @@ namespace VSLibRBDynamX {
         const std::vector<double>& GetViolationHistory() const { return violation_history; }
         const std::vector<double>& GetDeltalambdaHistory() const { return dlambda_history; }
 
+        /// 设置每次求解的时间预算（秒，≤ 0 表示不限时，默认）。
+        /// 求解每隔 GetClockCheckInterval() 轮读一次单调时钟，超时即停止迭代，
+        /// 返回目前为止的最优解（gamma_hat），并置 IsBudgetExceeded()。至少迭代一轮。
+        void SetTimeBudget(double seconds) { m_time_budget = seconds; }
+        double GetTimeBudget() const { return m_time_budget; }
+
+        /// 两次读时钟之间的迭代轮数（默认 4）
+        void SetClockCheckInterval(int n) { m_clock_interval = n < 1 ? 1 : n; }
+        int GetClockCheckInterval() const { return m_clock_interval; }
+
+        /// 上一次求解是否因时间预算用完而提前结束
+        bool IsBudgetExceeded() const { return m_budget_exceeded; }
+
+        /// 设置了时间预算时，是否按以往求解的每轮耗时把迭代上限收紧到预算内能完成的轮数（默认开启）。
+        /// 收紧后多数步在读时钟之前就按轮数结束，时钟检查只作为耗时突增时的保险
+        void SetAdaptiveIterationCap(bool val) { m_adaptive_cap = val; }
+        bool IsAdaptiveIterationCap() const { return m_adaptive_cap; }
+
+        /// 平滑后的耗时估计（秒，尚无统计时为 0）：每次求解的固定开销（装配、右端项等）与每轮迭代的耗时
+        double GetSecondsOverhead() const { return m_seconds_overhead; }
+        double GetSecondsPerIteration() const { return m_seconds_per_iteration; }
+
+        /// 下一次求解实际使用的迭代上限：GetMaxIterations() 与预算扣除固定开销后可完成轮数中的较小者（至少 1）
+        int GetIterationCap() const {
+            if (m_time_budget <= 0.0 || !m_adaptive_cap || m_seconds_per_iteration <= 0.0)
+                return m_max_iterations;
+            const double fit = (BUDGET_SAFETY * m_time_budget - m_seconds_overhead) / m_seconds_per_iteration;
+            if (fit >= m_max_iterations)
+                return m_max_iterations;
+            return fit < 1.0 ? 1 : static_cast<int>(fit);
+        }
+
     protected:
         RBDIterativeSolverVI()
             : m_max_iterations(1000), m_tolerance(1e-6), m_omega(1.0), m_shlambda(1.0), record_violation(false) {}
 
+        using BudgetClock = std::chrono::steady_clock;
+
+        static constexpr double BUDGET_SAFETY = 0.9;    ///< 迭代上限只用掉预算的这一比例
+        static constexpr double BUDGET_SMOOTHING = 0.25; ///< 耗时指数平滑中新样本的权重
+
+        /// 求解开始时调用：记录起始时刻并清除超时标志（本次求解已开始计时则不重复计时）
+        void BeginBudget() {
+            if (m_budget_running)
+                return;
+            m_budget_running = true;
+            m_budget_exceeded = false;
+            m_budget_start = BudgetClock::now();
+            m_budget_loop = m_budget_start;
+        }
+
+        /// 同 BeginBudget()，但视为此前已用掉 elapsed 秒（装配在另一个任务中完成、两者之间有等待时，
+        /// 只把装配本身计入预算）
+        void BeginBudget(double elapsed) {
+            if (m_budget_running)
+                return;
+            BeginBudget();
+            m_budget_start -= std::chrono::duration_cast<BudgetClock::duration>(std::chrono::duration<double>(elapsed));
+            m_budget_loop = m_budget_start;
+        }
+
+        /// 主循环开始前调用：此前的耗时计入固定开销
+        void BeginBudgetIterations() {
+            if (m_time_budget > 0.0)
+                m_budget_loop = BudgetClock::now();
+        }
+
+        /// 第 iter 轮开始前调用：设置了预算、iter > 0 且为检查间隔的整数倍、并且已超时时返回 true
+        bool BudgetExpired(int iter) {
+            if (iter == 0 || iter % m_clock_interval != 0)
+                return false;
+            return BudgetExpiredNow();
+        }
+
+        /// 不按轮数间隔、立即读时钟：设置了预算并且已超时时返回 true（用于一轮之内可能很长的回溯循环）
+        bool BudgetExpiredNow() {
+            if (m_time_budget <= 0.0)
+                return false;
+            const double elapsed = std::chrono::duration<double>(BudgetClock::now() - m_budget_start).count();
+            if (elapsed >= m_time_budget)
+                m_budget_exceeded = true;
+            return m_budget_exceeded;
+        }
+
+        /// 求解结束时调用：用本次的固定开销与每轮耗时更新平滑估计
+        void EndBudget(int iterations) {
+            m_budget_running = false;
+            if (m_time_budget <= 0.0 || iterations <= 0)
+                return;
+            const BudgetClock::time_point now = BudgetClock::now();
+            const double overhead = std::chrono::duration<double>(m_budget_loop - m_budget_start).count();
+            const double per_iteration = std::chrono::duration<double>(now - m_budget_loop).count() / iterations;
+            auto smooth = [](double& estimate, double sample) {
+                estimate = estimate > 0.0 ? (1.0 - BUDGET_SMOOTHING) * estimate + BUDGET_SMOOTHING * sample : sample;
+            };
+            smooth(m_seconds_overhead, overhead);
+            smooth(m_seconds_per_iteration, per_iteration);
+        }
+
         /// 迭代结束时调用，自动记录残差与乘子变化
         void AtIterationEnd(double max_violation, double delta_lambda, unsigned int iter) {
             if (!record_violation) return;
             if (iter >= violation_history.size()) {
-                violation_history.resize(m_max_iterations);
-                dlambda_history.resize(m_max_iterations);
+                std::size_t n = iter < static_cast<unsigned int>(m_max_iterations) ? m_max_iterations : iter + 1;
+                violation_history.resize(n);
+                dlambda_history.resize(n);
             }
             violation_history[iter] = max_violation;
             dlambda_history[iter] = delta_lambda;
@@ -85,6 +184,16 @@ namespace VSLibRBDynamX {
         bool record_violation;           ///< 是否记录迭代历史
         std::vector<double> violation_history;
         std::vector<double> dlambda_history;
+
+        double m_time_budget = 0.0;             ///< 每次求解的时间预算（秒，≤ 0 不限时）
+        int m_clock_interval = 4;               ///< 读时钟的间隔轮数
+        bool m_adaptive_cap = true;             ///< 是否按耗时统计收紧迭代上限
+        bool m_budget_exceeded = false;         ///< 上一次求解是否超时
+        bool m_budget_running = false;          ///< 本次求解是否已开始计时
+        double m_seconds_overhead = 0.0;        ///< 平滑后的每次固定开销（统计，属于求解器自身）
+        double m_seconds_per_iteration = 0.0;   ///< 平滑后的每轮耗时（统计，属于求解器自身）
+        BudgetClock::time_point m_budget_start; ///< 本次求解的起始时刻
+        BudgetClock::time_point m_budget_loop;  ///< 本次求解主循环的起始时刻
     };
 
 }  // namespace VSLibRBDynamX
@@ -0,0 +1,89 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Lipschitz Constant Estimator
+//
+// RBDLipschitzEstimator.h
+//   用幂迭代估计 N（Schur 补，含柔度 E）的最大特征值，即 APGD 目标函数梯度的
+//   Lipschitz 常数，作为 APGD 的初始 L。
+//   - 只需要算子的 SchurComplementProduct（矩阵自由），float / double 算子通用；
+//   - 特征向量跨 Solve 保留：相邻两步的 N 通常差别很小，以上一步的特征向量为初值，
+//     几轮迭代即可收敛，不必每步从头开始；λ 长度变化时改用全 1 向量重新开始；
+//   - 幂迭代给出的是最大特征值的下界，乘上安全系数后交给 APGD，
+//     使开头几轮不再因 L 偏小而连续回溯（每次回溯都要多做一次 Schur 补乘积）。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// 跨步热启动的幂迭代 Lipschitz 常数估计器
+    class RBDLipschitzEstimator {
+    public:
+        /// 每次估计的幂迭代轮数（每轮一次 Schur 补乘积，默认 4）
+        void SetIterations(int n) { m_iterations = n < 1 ? 1 : n; }
+        int GetIterations() const { return m_iterations; }
+
+        /// 安全系数：返回的 L = 安全系数 × 最大特征值估计（默认 1.1）
+        void SetSafetyFactor(double s) { m_safety = s < 1.0 ? 1.0 : s; }
+        double GetSafetyFactor() const { return m_safety; }
+
+        /// 估计 op 的最大特征值，返回乘上安全系数后的 L；N 作用在迭代向量上为 0 时返回 0。
+        /// v 与 Nv 是长度为 op.CountActiveConstraints() 的工作缓冲，内容会被覆盖
+        template <class TOperator, class Real>
+        double Estimate(TOperator& op, std::vector<Real>& v, std::vector<Real>& Nv) {
+            const std::size_t n = static_cast<std::size_t>(op.CountActiveConstraints());
+            if (m_vector.size() != n)
+                m_vector.assign(n, n > 0 ? 1.0 / std::sqrt(static_cast<double>(n)) : 0.0);
+
+            double norm = 0.0;
+            for (int k = 0; k < m_iterations; ++k) {
+                for (std::size_t i = 0; i < n; ++i)
+                    v[i] = static_cast<Real>(m_vector[i]);
+                op.SchurComplementProduct(v, Nv);
+
+                // m_vector 为单位向量，||N v|| 即本轮的特征值估计
+                double sq = 0.0;
+                for (std::size_t i = 0; i < n; ++i)
+                    sq += static_cast<double>(Nv[i]) * Nv[i];
+                norm = std::sqrt(sq);
+                if (!(norm > 0.0) || !std::isfinite(norm)) {
+                    // 落入零空间（或数值异常）：下次从全 1 向量重新开始
+                    m_vector.clear();
+                    m_estimate = 0.0;
+                    return 0.0;
+                }
+                for (std::size_t i = 0; i < n; ++i)
+                    m_vector[i] = Nv[i] / norm;
+            }
+            m_estimate = norm;
+            return m_safety * norm;
+        }
+
+        /// 最近一次的最大特征值估计（未乘安全系数）
+        double GetEstimate() const { return m_estimate; }
+
+        /// 丢弃保存的特征向量，下次从全 1 向量开始
+        void Reset() {
+            m_vector.clear();
+            m_estimate = 0.0;
+        }
+
+    private:
+        int m_iterations = 4;           ///< 每次估计的幂迭代轮数
+        double m_safety = 1.1;          ///< 安全系数
+        double m_estimate = 0.0;        ///< 最近一次的特征值估计
+        std::vector<double> m_vector;   ///< 上一次估计得到的单位特征向量（热启动）
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,95 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Mixed-Precision Schur Complement Operator
+//
+// RBDMixedPrecisionSchur.h
+//   单精度存储的 Schur 补算子：Jacobian 块 D 与 M^{-1}D^T 缓存均以 float 保存，
+//   乘子 λ 也是 float 向量；所有求和（速度累加、行点积）在 double 中完成。
+//   对带宽受限的大场景，每次迭代搬运的字节数约减半。
+//
+//   成员函数与 RBDSystemDescriptor 的同名函数语义一致（只是标量类型为 float），
+//   因此可以直接作为 RBDSolverAPGD 迭代模板的算子。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <vector>
+#include "RBDSystemDescriptor.h"
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// 单精度存储、双精度累加的 N = D M^{-1} D^T 算子
+    class RBDMixedPrecisionSchur {
+    public:
+        /// 从描述器（须已调用 UpdateCountsAndOffsets）拷贝出单精度的 D、M^{-1}D^T 与偏置
+        void Setup(const RBDSystemDescriptor& sysd);
+
+        /// 描述器的拓扑版本戳与上次 Setup 相同时只重算数值（描述器开启增量更新时
+        /// 只重算约束或关联变量的版本戳变化过的块），否则 Setup
+        void Update(const RBDSystemDescriptor& sysd);
+
+        /// λ 的长度
+        int CountActiveConstraints() const { return m_num_rows; }
+
+        /// result = D * (M^{-1}D^T * λ) + E * λ，累加在 double 中进行
+        void SchurComplementProduct(const std::vector<float>& lambda, std::vector<float>& result) const;
+
+        /// λ ← Proj_K(λ)（float 迭代量，或残差计算用的 double 缓冲）
+        template <class Real>
+        void ConstraintsProject(std::vector<Real>& lambda) const;
+
+        /// b = 各约束偏置
+        void BuildBiVector(std::vector<float>& b) const { b = m_bias; }
+
+    private:
+        struct Block {
+            int offset;      ///< λ 偏移
+            int dim;         ///< 约束维数
+            int cols;        ///< Jacobian 列数（关联变量自由度之和）
+            int jac_begin;   ///< 在 m_jac / m_eq 中的起点
+            int slot_begin;  ///< 在 m_slot_* 中的起点
+            int slot_end;
+        };
+
+        /// 重算第 i 个块的 D、M^{-1}D^T 与偏置，并记下版本戳
+        void AssembleBlock(const RBDConstraint* c, int i);
+
+        /// 约束及其关联变量版本戳中的最大值（版本戳全局单调，任一对象改变都会使它增大）
+        static unsigned long long BlockStamp(const RBDConstraint* c);
+
+        struct CustomProjection {
+            const RBDConstraint* con;
+            int offset;
+            int dim;
+        };
+
+        int m_num_rows = 0;
+        int m_num_dofs = 0;
+        std::vector<Block> m_blocks;
+        std::vector<unsigned long long> m_block_stamps; ///< 各块上次装配时的 BlockStamp
+        unsigned long long m_topology_stamp = 0;  ///< 上次 Setup 时描述器的拓扑版本戳
+        std::vector<float> m_jac;               ///< D 块，行主序
+        std::vector<float> m_eq;                ///< M^{-1}D^T 块，与 m_jac 同布局
+        std::vector<int> m_slot_offset;         ///< 变量在全局速度向量中的偏移
+        std::vector<int> m_slot_dof;            ///< 变量自由度
+        std::vector<float> m_bias;              ///< 偏置
+        std::vector<float> m_compliance;        ///< E 的对角元
+        bool m_has_compliance = false;          ///< m_compliance 是否有非零元
+        std::vector<int> m_unilateral;          ///< λ ≥ 0 的连续区间，成对存放 [begin, end)
+        std::vector<CustomProjection> m_custom; ///< 需要虚函数投影的约束
+
+        std::vector<std::vector<double>> m_J;   ///< 装配用的 Jacobian 缓冲
+        std::vector<double> m_mf;               ///< 装配用的 M^{-1} f 缓冲
+        mutable std::vector<double> m_v;        ///< 速度累加缓冲（double）
+        mutable std::vector<double> m_scratch;  ///< float λ 的 CUSTOM 投影缓冲
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,100 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Schur Complement Snapshot
+//
+// RBDSchurSnapshot.h
+//   描述器在某一时刻的双精度快照：Jacobian 块 D、M^{-1}D^T 块、偏置与投影信息
+//   全部拷贝到自有存储中，之后的 Schur 补乘积与投影不再访问变量。
+//   RBDSolverAPGD::SolveAsync 在调用线程上建立快照，再在线程池上对快照迭代，
+//   求解期间宿主可以继续修改（或为下一步重建）变量与描述器。
+//
+//   成员函数与 RBDSystemDescriptor 的同名函数语义一致，可以直接作为 APGD 迭代模板的算子。
+//   CUSTOM 约束的投影仍通过 RBDConstraint::Project() 回调，因此这些约束对象
+//   必须存活到求解结束，且 Project() 只能读取约束自身不变的参数。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <vector>
+#include "RBDSystemDescriptor.h"
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// 双精度的 N = D M^{-1} D^T 快照算子
+    class RBDSchurSnapshot {
+    public:
+        /// 从描述器（须已调用 UpdateCountsAndOffsets）拷贝出 D、M^{-1}D^T、偏置与投影信息
+        void Setup(const RBDSystemDescriptor& sysd);
+
+        /// λ 的长度
+        int CountActiveConstraints() const { return m_num_rows; }
+
+        /// result = D * (M^{-1}D^T * λ) + E * λ
+        void SchurComplementProduct(const std::vector<double>& lambda, std::vector<double>& result) const;
+
+        /// λ ← Proj_K(λ)
+        void ConstraintsProject(std::vector<double>& lambda) const;
+
+        /// b = 各约束偏置
+        void BuildBiVector(std::vector<double>& b) const { b = m_bias; }
+
+        /// λ 开头的连续 BILATERAL 行与紧随其后的连续 UNILATERAL 行（见 RBDSystemDescriptor）
+        void GetProjectionLayout(int& bilateral_end, int& unilateral_end) const {
+            bilateral_end = m_bilateral_end;
+            unilateral_end = m_unilateral_end;
+        }
+
+        /// v = M^{-1}D^T λ 写回快照建立时登记的变量（SetState）。
+        /// 只用快照自己的布局与 M^{-1}D^T，不访问描述器：描述器此时可能已为下一步重建
+        void SetUnknowns(const std::vector<double>& lambda) const;
+
+    private:
+        /// m_v = M^{-1}D^T λ（串行散射，求和顺序固定）
+        void ComputeVelocities(const std::vector<double>& lambda) const;
+
+        struct Block {
+            int offset;      ///< λ 偏移
+            int dim;         ///< 约束维数
+            int cols;        ///< Jacobian 列数（关联变量自由度之和）
+            int jac_begin;   ///< 在 m_jac / m_eq 中的起点
+            int slot_begin;  ///< 在 m_slot_* 中的起点
+            int slot_end;
+        };
+
+        struct CustomProjection {
+            const RBDConstraint* con;
+            int offset;
+            int dim;
+        };
+
+        int m_num_rows = 0;
+        int m_num_dofs = 0;
+        int m_bilateral_end = 0;
+        int m_unilateral_end = 0;
+        std::vector<Block> m_blocks;
+        std::vector<double> m_jac;              ///< D 块，行主序
+        std::vector<double> m_eq;               ///< M^{-1}D^T 块，与 m_jac 同布局
+        std::vector<int> m_slot_offset;         ///< 变量在全局速度向量中的偏移
+        std::vector<int> m_slot_dof;            ///< 变量自由度
+        std::vector<double> m_bias;             ///< 偏置
+        std::vector<double> m_compliance;       ///< E 的对角元（全为 0 时为空）
+        std::vector<int> m_unilateral;          ///< λ ≥ 0 的连续区间，成对存放 [begin, end)
+        std::vector<int> m_cone_offsets;        ///< FRICTION_CONE 约束的 λ 偏移
+        std::vector<double> m_cone_mu;          ///< FRICTION_CONE 约束的摩擦系数
+        std::vector<CustomProjection> m_custom; ///< 需要虚函数投影的约束
+        std::vector<RBDVariables*> m_vars;      ///< 登记的变量（SetUnknowns 写回）
+        std::vector<int> m_var_offset;          ///< 快照建立时各变量的偏移
+        std::vector<int> m_var_dof;             ///< 快照建立时各变量的自由度
+
+        mutable std::vector<double> m_v;        ///< 速度累加缓冲
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,63 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Runtime SIMD Dispatch
+//
+// RBDSimd.h
+//   运行时（CPUID + XGETBV）检测 CPU 与操作系统支持的 SIMD 指令集，
+//   供各个数值内核在 scalar / SSE2 / AVX2 / AVX-512 实现之间选择。
+//   不依赖编译期 -march：AVX2/AVX-512 内核以函数级 target 属性单独编译，
+//   同一个可执行文件可以在不同代际的机器上运行。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RBD_SIMD_X86 1
+#else
+#define RBD_SIMD_X86 0
+#endif
+
+// 函数级目标指令集：GCC/Clang 需要 target 属性才能在未开 -mavx2 的翻译单元中使用对应内建函数；
+// MSVC 允许直接使用所有内建函数，无需标注。
+#if RBD_SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define RBD_TARGET_SSE2 __attribute__((target("sse2")))
+#define RBD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define RBD_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define RBD_TARGET_SSE2
+#define RBD_TARGET_AVX2
+#define RBD_TARGET_AVX512
+#endif
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// SIMD 指令集级别（由低到高，高级别蕴含低级别）
+    enum class RBDSimdLevel {
+        SCALAR = 0,  ///< 纯标量实现
+        SSE2 = 1,    ///< 128 位，2 × double
+        AVX2 = 2,    ///< 256 位，4 × double，含 FMA
+        AVX512 = 3   ///< 512 位，8 × double（AVX-512F）
+    };
+
+    /// 本机硬件与操作系统共同支持的最高级别（首次调用时检测，结果缓存）
+    RBDSimdLevel RBDDetectSimdLevel();
+
+    /// 当前生效的级别 = min(检测结果, RBDSetSimdLevel 设置的上限)
+    RBDSimdLevel RBDGetSimdLevel();
+
+    /// 设置级别上限（用于测试各条路径，或在异构集群上强制结果一致）；
+    /// 高于硬件能力的值会被截断到 RBDDetectSimdLevel()
+    void RBDSetSimdLevel(RBDSimdLevel level);
+
+    /// 级别名称（"scalar" / "sse2" / "avx2" / "avx512"）
+    const char* RBDSimdLevelName(RBDSimdLevel level);
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
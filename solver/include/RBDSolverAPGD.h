@@ -20,7 +20,20 @@
 #pragma once
 
 #include "RBDIterativeSolverVI.h"
+#include "RBDLipschitzEstimator.h"
 #include "RBDSystemDescriptor.h"
+#include "RBDMixedPrecisionSchur.h"
+#include "RBDSchurSnapshot.h"
+#include "RBDSolverWorkspace.h"
+#include "RBDVectorKernels.h"
+#include "RBDThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <type_traits>
 #include <vector>
 
 namespace VSLibRBDynamX {
@@ -28,6 +41,52 @@ namespace VSLibRBDynamX {
     /// @addtogroup VSLibRBDynamX_solver
     /// @{
 
+    struct RBDAsyncSolveState;
+
+    /// RBDSolverAPGD::SolveAsync 返回的句柄（只可移动）。
+    /// 求解在线程池上进行，结果只在 Join() 时由调用线程按快照的布局写回变量；
+    /// 未 Join 就销毁句柄时会取消求解并等待其结束，不写回任何结果。
+    class RBDSolveHandle {
+    public:
+        RBDSolveHandle() = default;
+        ~RBDSolveHandle();
+        RBDSolveHandle(RBDSolveHandle&&) noexcept = default;
+        RBDSolveHandle& operator=(RBDSolveHandle&& other) noexcept;
+        RBDSolveHandle(const RBDSolveHandle&) = delete;
+        RBDSolveHandle& operator=(const RBDSolveHandle&) = delete;
+
+        /// 是否关联着一个尚未 Join 的求解
+        bool IsValid() const { return m_state != nullptr && !m_joined; }
+
+        /// 求解是否已经结束（不阻塞）
+        bool IsReady() const;
+
+        /// 请求提前结束：迭代在下一轮开始前停止，Join 仍写回目前的最优解
+        void Cancel();
+
+        /// 等待求解结束（等待期间当前线程也执行线程池中的任务），
+        /// 在调用线程上把最优 λ 对应的速度 M^{-1}D^T λ 按快照建立时的布局写回变量
+        /// （不经过描述器，描述器在求解期间可以已为下一步重建），返回残差
+        double Join();
+
+        /// Join 之后可查询：迭代轮数、是否因 Cancel 或时间预算提前结束、最终 λ
+        int GetIterations() const;
+        bool WasCancelled() const;
+        bool IsBudgetExceeded() const;
+        const std::vector<double>& GetLambda() const;
+
+        /// Join 之后可查询：本次求解更新过的 Lipschitz 估计器（特征向量）。
+        /// 句柄不持有发起求解的 RBDSolverAPGD，需要跨步热启动时由调用者并回，例如
+        /// solver.GetLipschitzEstimator() = handle.GetLipschitzEstimator()；
+        /// 同时进行的多个求解由调用者决定保留哪一个
+        const RBDLipschitzEstimator& GetLipschitzEstimator() const;
+
+    private:
+        friend class RBDSolverAPGD;
+        std::shared_ptr<RBDAsyncSolveState> m_state;
+        bool m_joined = false;
+    };
+
     /// An iterative solver based on Nesterov's Projected Gradient Descent.
     ///
     /// The APGD algorithm is efficient for large-scale CCP systems and supports
@@ -41,39 +100,522 @@ namespace VSLibRBDynamX {
         ~RBDSolverAPGD() = default;
 
         /// Performs the solution of the problem.
-        /// 核心函数，执行 APGD 算法，求解系统 VI 问题。
+        /// 核心函数，执行 APGD 算法，求解系统 VI 问题（通过虚接口访问描述器）。
         double Solve(RBDSystemDescriptor& sysd);
 
+        /// 编译期特化的求解入口。
+        /// 当 TDescriptor 是 final 的具体描述器（如 RBDStaticSystemDescriptor）时，
+        /// Schur 补乘积、投影等调用全部静态绑定，可内联进 APGD 主循环。
+        template <class TDescriptor>
+        double SolveSpecialized(TDescriptor& sysd);
+
+        /// 异步求解：在调用线程上准备描述器（见 Setup）并把它拷贝成 RBDSchurSnapshot，
+        /// 然后在 RBDGetThreadPool() 上用本求解器当前参数的副本迭代，立即返回句柄。
+        /// 求解期间本求解器可以继续用于其它 Solve；描述器与变量可以被修改甚至重建，
+        /// 但变量与约束对象必须存活到 Join（Join 写回变量，CUSTOM 约束的投影仍回调约束本身）。
+        /// 本求解器不必存活到 Join：Lipschitz 估计器以本求解器当前的特征向量为初值，
+        /// 更新后的结果经 RBDSolveHandle::GetLipschitzEstimator() 取回。
+        /// 迭代只在工作线程上进行，调用线程不会在之后的 Wait / ParallelFor 中接手它；
+        /// 线程池只有 1 个线程（没有工作线程）时，求解在本调用内同步完成，Join 只做写回。
+        RBDSolveHandle SolveAsync(RBDSystemDescriptor& sysd);
+
+        /// 结构准备：调用 UpdateCountsAndOffsets 并记下描述器的拓扑版本戳。
+        /// 此后只要 GetTopologyStamp() 不变，求解只调用 UpdateValues() 刷新数值，
+        /// 沿用偏移、投影分桶、D^T 邻接表与刚体登记；Solve 系列入口会按需自动调用
+        bool Setup(RBDSystemDescriptor& sysd);
+
+        /// 使下一次求解无条件重建结构
+        void ForceSetup() { m_setup_stamp = 0; }
+
+        /// 上一次求解是否沿用了已有结构（只刷新了数值）
+        bool IsSetupReused() const { return m_setup_reused; }
+
+        /// 启用混合精度求解（默认关闭）：
+        /// D、M^{-1}D^T 与 λ 迭代量以 float 存储，点积/残差/Lipschitz 判据在 double 中累加，
+        /// 单精度迭代结束后再以其结果为初值做至多 GetRefinementIterations() 轮双精度精化。
+        void EnableMixedPrecision(bool val) { m_mixed_precision = val; }
+        bool IsMixedPrecision() const { return m_mixed_precision; }
+
+        /// 混合精度模式下双精度精化的最大轮数（默认 20）
+        void SetRefinementIterations(int n) { m_refine_iterations = n; }
+        int GetRefinementIterations() const { return m_refine_iterations; }
+
+        /// 用幂迭代估计 N 的最大特征值作为初始 L（默认关闭，此时 L 由 N 作用在全 1 向量上粗估）。
+        /// 特征向量跨 Solve 保留并作为下一次的初值，见 RBDLipschitzEstimator
+        void EnableLipschitzEstimate(bool val) { m_lipschitz_estimate = val; }
+        bool IsLipschitzEstimate() const { return m_lipschitz_estimate; }
+
+        /// Lipschitz 估计器（设置幂迭代轮数与安全系数，查询最近的特征值估计）
+        RBDLipschitzEstimator& GetLipschitzEstimator() { return m_lipschitz; }
+        const RBDLipschitzEstimator& GetLipschitzEstimator() const { return m_lipschitz; }
+
+        /// 上一次求解中回溯（L 加倍）的次数
+        int GetBacktracks() const { return m_backtracks; }
+
         /// Return the tolerance error reached during the last solve.
         /// 对于 APGD 求解器，这是投影梯度的范数。
         double GetError() const { return residual; }
 
+        /// 返回上一次求解的迭代轮数（混合精度模式下包含精化轮数）
+        int GetIterations() const { return m_iterations; }
+
         /// 导出右端项向量 r
-        void Dump_Rhs(std::vector<double>& temp) const { temp = r; }
+        void Dump_Rhs(std::vector<double>& temp) const { temp = m_vec.r; }
 
         /// 导出最终的拉格朗日乘子向量 lambda
-        void Dump_Lambda(std::vector<double>& temp) const { temp = gamma; }
+        void Dump_Lambda(std::vector<double>& temp) const { temp = m_vec.gamma_hat; }
 
     private:
+        friend class RBDSolveHandle;
+        friend class RBDStepPipeline;
+
+        /// 拷贝另一个求解器的参数（迭代上限、容差、时间预算、混合精度、Lipschitz 估计等），
+        /// 不拷贝工作区与估计器保存的特征向量；
+        /// 本求解器已有每轮耗时统计时保留自己的统计
+        void CopySettings(const RBDSolverAPGD& other);
+
+        /// 求解前的描述器准备：版本戳与上次 Setup 相同时只刷新数值，否则 Setup
+        template <class TDescriptor>
+        void Prepare(TDescriptor& sysd);
+
+        /// 对已装配好的算子求解（混合精度时 m_mixed 须已 Setup），最优解留在 m_vec.gamma_hat
+        template <class TOperator>
+        void SolveAssembled(TOperator& op);
+
         /// 生成 APGD 算法中的 Schur 补右端向量 r
-        void SchurBvectorCompute(RBDSystemDescriptor& sysd);
-        int m_iterations;    ///< 当前迭代轮数
+        template <class TOperator, class Real>
+        void SchurBvectorCompute(TOperator& op, RBDSolverWorkspace<Real>& w);
+
+        /// 最优解当前所在的缓冲区（用于避免每轮把 gammaNew 整段拷贝到 gamma_hat）
+        enum class BestLocation { GAMMA, GAMMA_NEW, GAMMA_HAT };
+
+        /// 计算 gammaNew 的投影梯度范数，作为收敛残差（调用前 tmp 须为 N * gammaNew）
+        template <class TOperator, class Real>
+        double Res4(TOperator& op, RBDSolverWorkspace<Real>& w);
+
+        // ---- 双精度路径的融合内核（按 λ 的投影分段调用，见 GetProjectionLayout） ----
+        // 长向量按固定长度 REDUCE_BLOCK 切块，在 RBDGetThreadPool() 上并行；
+        // 各块的部分和再按固定的二叉树顺序相加。分块与求和顺序都与线程数无关，
+        // 因此 1 个线程和 64 个线程得到逐位相同的 λ。
+
+        // 块长取 1024：一次任务分派约 0.5~1 µs，FusedUpdate 约 1.1 ns/元素，
+        // 每块约 1 µs 的工作刚好抵过分派开销；约 1 万个约束的问题有 10 块，可以分给多个线程
+        static const int REDUCE_BLOCK = 1024;  ///< 归约分块长度（与线程数无关）
+
+        /// 把 [0, n) 按 REDUCE_BLOCK 切块并行执行 f(begin, end, block)，返回块数
+        template <class F>
+        int ForEachChunk(int n, F&& f);
+
+        /// p[0], p[stride], ..., p[(n-1)*stride] 的二叉树求和（顺序只取决于 n）
+        static double TreeSum(const double* p, int n, int stride) {
+            if (n <= 0)
+                return 0.0;
+            if (n == 1)
+                return p[0];
+            const int h = n / 2;
+            return TreeSum(p, h, stride) + TreeSum(p + h * stride, n - h, stride);
+        }
+
+        /// g += r，返回 f(y)（调用前 g = N y）
+        double GradientObjective(const RBDVectorKernels& K, RBDSolverWorkspace<double>& w);
+
+        /// gammaNew = Proj(y - t g)：前两段在同一遍中投影，其余段再交给 ConstraintsProject
+        template <class TOperator>
+        void FusedStep(TOperator& op, const RBDVectorKernels& K, RBDSolverWorkspace<double>& w, double t);
+
+        /// 已知 tmp = N gammaNew 时，一遍算出回溯判据、Nesterov 外推 yNew 与残差平方和（见 RBDVectorKernels::FusedUpdate）
+        template <class TOperator>
+        void FusedUpdate(TOperator& op, const RBDVectorKernels& K, RBDSolverWorkspace<double>& w,
+            double beta, double sums[6]);
+
+        /// APGD 主循环。TOperator 提供 SchurComplementProduct / ConstraintsProject，
+        /// 可以是描述器本身（double）或 RBDMixedPrecisionSchur（float）。
+        /// warm_start 为 true 时以 w.gamma 为初值，否则从零开始。
+        /// initial_residual 为初值的残差：迭代中的解不比它好时（或一轮也未迭代）保留初值
+        template <class TOperator, class Real>
+        void Iterate(TOperator& op, RBDSolverWorkspace<Real>& w, int max_iterations, bool warm_start,
+            double initial_residual = 1e30);
 
-        /// 计算当前解的投影梯度范数，作为收敛残差
-        double Res4(const std::vector<double>& lambda) const;
+        /// 点积，始终在 double 中累加
+        template <class Real>
+        static double Dot(const std::vector<Real>& a, const std::vector<Real>& b) {
+            double s = 0.0;
+            for (std::size_t i = 0; i < a.size(); ++i) s += static_cast<double>(a[i]) * b[i];
+            return s;
+        }
 
+        int m_iterations;                ///< 当前迭代轮数
         double residual;                 ///< 当前迭代收敛误差
         int nc;                          ///< 问题维数 (约束数)
-        std::vector<double> gamma;       ///< 当前拉格朗日乘子
-        std::vector<double> gammaNew;    ///< 下一步拉格朗日乘子
-        std::vector<double> gamma_hat;   ///< 历史最佳解
-        std::vector<double> y;           ///< Nesterov 加速辅助变量
-        std::vector<double> yNew;        ///< 下一步辅助变量
-        std::vector<double> g;           ///< 当前梯度
-        std::vector<double> r;           ///< Schur 补右端向量
-        std::vector<double> tmp;         ///< 中间临时缓冲区
+        bool m_mixed_precision;          ///< 是否启用混合精度
+        int m_refine_iterations;         ///< 混合精度下双精度精化的最大轮数
+        bool m_lipschitz_estimate = false;  ///< 是否用幂迭代估计初始 L
+        RBDLipschitzEstimator m_lipschitz;  ///< 初始 L 的估计器（特征向量跨 Solve 保留）
+        int m_backtracks = 0;            ///< 上一次求解的回溯次数
+        unsigned long long m_setup_stamp = 0;  ///< 上次 Setup 时描述器的拓扑版本戳（0 表示尚未 Setup）
+        bool m_setup_reused = false;     ///< 上一次求解是否沿用了已有结构
+
+        RBDSolverWorkspace<double> m_vec;           ///< 双精度迭代工作区（跨 Solve 复用）
+        RBDSolverWorkspace<float> m_vec_f;          ///< 单精度迭代工作区（混合精度模式）
+        RBDMixedPrecisionSchur m_mixed;  ///< 单精度 Schur 补算子（混合精度模式）
+        std::vector<double> m_res;       ///< 残差计算用的双精度缓冲
+        int m_bilateral_end = 0;         ///< λ 中无需投影段的终点
+        int m_unilateral_end = 0;        ///< λ 中逐元素 λ ≥ 0 段的终点
+        std::vector<double> m_partials;  ///< 各归约块的部分和（每块 6 个）
+        const std::atomic<bool>* m_cancel = nullptr;  ///< 异步求解的取消标志（同步求解时为空）
     };
 
     /// @} VSLibRBDynamX_solver
 
+    // -------------------------------------------------------------------------
+    // 模板实现
+    // -------------------------------------------------------------------------
+
+    // 构建 Schur 补右端向量 r = D M^{-1} f + b（这里外力项为零，r 即约束偏置 b）
+    template <class TOperator, class Real>
+    void RBDSolverAPGD::SchurBvectorCompute(TOperator& op, RBDSolverWorkspace<Real>& w) {
+        op.BuildBiVector(w.r);
+    }
+
+    // 计算投影梯度范数：|| (λ - proj(λ - gd*(N*λ + r))) / gd ||
+    // gd 很小，单精度下 λ - gd*(...) 会被舍入回 λ，因此这里始终在 double 缓冲中计算
+    template <class TOperator, class Real>
+    double RBDSolverAPGD::Res4(TOperator& op, RBDSolverWorkspace<Real>& w) {
+        const double gdiff = 1.0 / (static_cast<double>(nc) * nc);
+        m_res.resize(nc);
+        for (int i = 0; i < nc; ++i)
+            m_res[i] = w.gammaNew[i] - gdiff * (static_cast<double>(w.tmp[i]) + w.r[i]);
+        op.ConstraintsProject(m_res);
+        double res = 0.0;
+        for (int i = 0; i < nc; ++i) {
+            double diff = (w.gammaNew[i] - m_res[i]) / gdiff;
+            res += diff * diff;
+        }
+        return std::sqrt(res);
+    }
+
+    template <class F>
+    int RBDSolverAPGD::ForEachChunk(int n, F&& f) {
+        const int chunks = (n + REDUCE_BLOCK - 1) / REDUCE_BLOCK;
+        m_partials.resize(6 * static_cast<std::size_t>(chunks));
+        // 每个任务至少 1 块，单线程时 ParallelFor 直接在当前线程按块顺序执行
+        RBDGetThreadPool().ParallelFor(0, chunks, 1, [&](int cb, int ce) {
+            for (int c = cb; c < ce; ++c) {
+                const int b = c * REDUCE_BLOCK;
+                f(b, b + REDUCE_BLOCK < n ? b + REDUCE_BLOCK : n, c);
+            }
+        });
+        return chunks;
+    }
+
+    inline double RBDSolverAPGD::GradientObjective(const RBDVectorKernels& K, RBDSolverWorkspace<double>& w) {
+        const int chunks = ForEachChunk(nc, [&](int b, int e, int c) {
+            m_partials[c] = K.GradientObjective(e - b, w.g.data() + b, w.r.data() + b, w.y.data() + b);
+        });
+        return TreeSum(m_partials.data(), chunks, 1);
+    }
+
+    template <class TOperator>
+    void RBDSolverAPGD::FusedStep(TOperator& op, const RBDVectorKernels& K, RBDSolverWorkspace<double>& w, double t) {
+        const int b = m_bilateral_end, u = m_unilateral_end;
+        double* x = w.gammaNew.data();
+        const double* y = w.y.data();
+        const double* g = w.g.data();
+        ForEachChunk(nc, [&](int cb, int ce, int) {
+            // 块 [cb, ce) 与三段 [0, b)、[b, u)、[u, nc) 的交集
+            const int i0 = cb < b ? cb : b, i1 = ce < b ? ce : b;
+            K.ProjectedWaxpy(i1 - i0, false, x + i0, y + i0, -t, g + i0);
+            const int j0 = cb < b ? b : (cb < u ? cb : u), j1 = ce < b ? b : (ce < u ? ce : u);
+            K.ProjectedWaxpy(j1 - j0, true, x + j0, y + j0, -t, g + j0);
+            const int k0 = cb < u ? u : cb, k1 = ce < u ? u : ce;
+            K.ProjectedWaxpy(k1 - k0, false, x + k0, y + k0, -t, g + k0);
+        });
+        if (u < nc)
+            op.ConstraintsProject(w.gammaNew);
+    }
+
+    template <class TOperator>
+    void RBDSolverAPGD::FusedUpdate(TOperator& op, const RBDVectorKernels& K, RBDSolverWorkspace<double>& w,
+        double beta, double sums[6]) {
+        const double gdiff = 1.0 / (static_cast<double>(nc) * nc);
+        const int seg_begin[3] = { 0, m_bilateral_end, m_unilateral_end };
+        const int seg_end[3] = { m_bilateral_end, m_unilateral_end, nc };
+        m_res.resize(nc);
+        const int chunks = ForEachChunk(nc, [&](int cb, int ce, int c) {
+            double* part = m_partials.data() + 6 * c;
+            for (int k = 0; k < 6; ++k)
+                part[k] = 0.0;
+            for (int s = 0; s < 3; ++s) {
+                const int i0 = seg_begin[s] > cb ? seg_begin[s] : cb;
+                const int i1 = seg_end[s] < ce ? seg_end[s] : ce;
+                if (i1 <= i0)
+                    continue;
+                double seg[6];
+                K.FusedUpdate(i1 - i0, s, w.gammaNew.data() + i0, w.gamma.data() + i0, w.y.data() + i0,
+                    w.tmp.data() + i0, w.r.data() + i0, w.g.data() + i0, beta, gdiff,
+                    w.yNew.data() + i0, m_res.data() + i0, seg);
+                for (int k = 0; k < 6; ++k)
+                    part[k] += seg[k];
+            }
+        });
+        for (int k = 0; k < 6; ++k)
+            sums[k] = TreeSum(m_partials.data() + k, chunks, 6);
+        // 需要虚函数投影的尾段：残差点已写入 m_res，投影后补上它的残差平方和
+        if (m_unilateral_end < nc) {
+            op.ConstraintsProject(m_res);
+            sums[5] += K.DistSquared(nc - m_unilateral_end, w.gammaNew.data() + m_unilateral_end,
+                m_res.data() + m_unilateral_end);
+        }
+    }
+
+    template <class TDescriptor>
+    void RBDSolverAPGD::Prepare(TDescriptor& sysd) {
+        const unsigned long long stamp = sysd.GetTopologyStamp();
+        m_setup_reused = stamp == m_setup_stamp;
+        if (!m_setup_reused) {
+            Setup(sysd);
+            return;
+        }
+        // 描述器在数值刷新时发现拓扑已变（如新增了临时约束）会自行完整重建并更新版本戳
+        sysd.UpdateValues();
+        m_setup_stamp = sysd.GetTopologyStamp();
+        m_setup_reused = m_setup_stamp == stamp;
+    }
+
+    template <class TDescriptor>
+    double RBDSolverAPGD::SolveSpecialized(TDescriptor& sysd) {
+        // 时间预算从装配开始计
+        BeginBudget();
+
+        // 构建尺寸（λ 长度为所有约束维数之和）；拓扑未变时只刷新数值
+        Prepare(sysd);
+        if (m_mixed_precision && sysd.CountActiveConstraints() > 0)
+            m_mixed.Update(sysd);
+
+        SolveAssembled(sysd);
+
+        // 写回解
+        if (nc > 0)
+            sysd.SetUnknowns(m_vec.gamma_hat);
+
+        return residual;
+    }
+
+    template <class TOperator>
+    void RBDSolverAPGD::SolveAssembled(TOperator& op) {
+        BeginBudget();
+        nc = op.CountActiveConstraints();
+        m_vec.Resize(nc);
+        m_iterations = 0;
+        m_backtracks = 0;
+        residual = 0.0;
+
+        if (nc == 0) {
+            EndBudget(0);
+            return;
+        }
+
+        // 设置了时间预算时，上限按以往的每轮耗时收紧
+        const int max_iterations = GetIterationCap();
+        if (m_mixed_precision) {
+            // 单精度阶段
+            m_vec_f.Resize(nc);
+            Iterate(m_mixed, m_vec_f, max_iterations, false);
+            int float_iterations = m_iterations;
+
+            // 双精度精化：以单精度最优解及其残差为初始最优，精化不能改进时保留单精度结果
+            // （已取消或超时时跳过，直接采用单精度结果）
+            for (int i = 0; i < nc; ++i)
+                m_vec.gamma[i] = m_vec_f.gamma_hat[i];
+            if ((m_cancel && m_cancel->load(std::memory_order_relaxed)) || m_budget_exceeded) {
+                m_vec.gamma_hat = m_vec.gamma;
+            } else {
+                Iterate(op, m_vec, m_refine_iterations, true, residual);
+                m_iterations += float_iterations;
+            }
+        } else {
+            Iterate(op, m_vec, max_iterations, false);
+        }
+        EndBudget(m_iterations);
+    }
+
+    template <class TOperator, class Real>
+    void RBDSolverAPGD::Iterate(TOperator& op, RBDSolverWorkspace<Real>& w, int max_iterations, bool warm_start,
+        double initial_residual) {
+        auto& gamma = w.gamma;
+        auto& gammaNew = w.gammaNew;
+        auto& gamma_hat = w.gamma_hat;
+        auto& y = w.y;
+        auto& yNew = w.yNew;
+        auto& g = w.g;
+        auto& r = w.r;
+        auto& tmp = w.tmp;
+
+        // 双精度时向量运算走运行时分派的 SIMD 内核，单精度保留标量循环
+        constexpr bool use_kernels = std::is_same<Real, double>::value;
+        [[maybe_unused]] const RBDVectorKernels& K = RBDGetVectorKernels();
+
+        // 构建 Schur 补右端向量
+        SchurBvectorCompute(op, w);
+        if constexpr (use_kernels)
+            op.GetProjectionLayout(m_bilateral_end, m_unilateral_end);
+
+        // 算法参数
+        double L = 1.0;
+        double t = 1.0;
+        double theta = 1.0;
+        double thetaNew = 1.0;
+        double Beta = 0.0;
+        double obj1 = 0.0;
+        double obj2 = 0.0;
+
+        // 初始 guess：gamma 置零或由调用者通过 warm start 设置
+        if (!warm_start)
+            std::fill(gamma.begin(), gamma.end(), Real(0));
+
+        if (m_lipschitz_estimate) {
+            // 初始步长：幂迭代估计的最大特征值（以上一次的特征向量为初值）
+            L = m_lipschitz.Estimate(op, tmp, yNew);
+        } else {
+            // 初始步长：L = ||N (γ0 - γ1)|| / ||γ0 - γ1||，γ1 = γ0 - 1
+            std::fill(tmp.begin(), tmp.end(), Real(1));
+            op.SchurComplementProduct(tmp, yNew);
+            L = std::sqrt(Dot(yNew, yNew) / Dot(tmp, tmp));
+        }
+        if (!(L > 0.0))
+            L = 1.0;
+        t = 1.0 / L;
+
+        residual = initial_residual;
+        y = gamma;
+        BestLocation best = BestLocation::GAMMA;  // 初值作为初始最优
+
+        // 主循环（此前的右端项与初始步长计入时间预算的固定开销；精化阶段整体计入迭代）
+        if (!warm_start)
+            BeginBudgetIterations();
+        for (m_iterations = 0; m_iterations < max_iterations; ++m_iterations) {
+            if (m_cancel && m_cancel->load(std::memory_order_relaxed))
+                break;
+            if (BudgetExpired(m_iterations))
+                break;
+
+            // g = N * y + r
+            // f(y) = 0.5 y'Ny + y'r = y'(0.5 g + 0.5 r)
+            op.SchurComplementProduct(y, g);
+            double fy = 0.0;
+            if constexpr (use_kernels) {
+                fy = GradientObjective(K, w);
+            } else {
+                for (int i = 0; i < nc; ++i)
+                    g[i] += r[i];
+                for (int i = 0; i < nc; ++i)
+                    fy += static_cast<double>(y[i]) * (0.5 * g[i] + 0.5 * r[i]);
+            }
+
+            // Nesterov 系数只依赖 theta，先算出来，双精度路径在回溯判据的同一遍中完成外推
+            thetaNew = (-theta * theta + theta * std::sqrt(theta * theta + 4.0)) / 2.0;
+            Beta = theta * (1.0 - theta) / (theta * theta + thetaNew);
+            double fused[6];  // 见 RBDVectorKernels::FusedUpdate
+
+            // 乘子更新并投影，不满足充分下降条件时回溯（L 加倍）
+            bool budget_spent = false;
+            while (true) {
+                if constexpr (use_kernels) {
+                    FusedStep(op, K, w, t);
+                } else {
+                    for (int i = 0; i < nc; ++i)
+                        gammaNew[i] = static_cast<Real>(y[i] - t * g[i]);
+                    op.ConstraintsProject(gammaNew);
+                }
+
+                // obj1 = f(γNew) = 0.5 γNew'NγNew + γNew'r，tmp = N γNew
+                op.SchurComplementProduct(gammaNew, tmp);
+                double step2 = 0.0;  // ||γNew - y||^2
+                if constexpr (use_kernels) {
+                    FusedUpdate(op, K, w, Beta, fused);
+                    obj1 = fused[0];
+                    obj2 = fy + fused[1] + 0.5 * L * fused[2];
+                    step2 = fused[2];
+                } else {
+                    obj1 = 0.0;
+                    obj2 = fy;
+                    for (int i = 0; i < nc; ++i) {
+                        double d = static_cast<double>(gammaNew[i]) - y[i];
+                        obj1 += static_cast<double>(gammaNew[i]) * (0.5 * tmp[i] + r[i]);
+                        obj2 += g[i] * d + 0.5 * L * d * d;
+                        step2 += d * d;
+                    }
+                }
+                // 投影后 γNew == y 时 obj1 与 f(y) 只差舍入误差，继续加倍 L 不会改变结果
+                if (obj1 <= obj2 || step2 == 0.0)
+                    break;
+                // 每次回溯都是一次 Schur 补乘积，L 严重低估时一轮可以回溯许多次：
+                // 预算用完就放弃本轮的 γNew，返回目前的最优解
+                if (BudgetExpiredNow()) {
+                    budget_spent = true;
+                    break;
+                }
+                L = 2.0 * L;
+                t = 1.0 / L;
+                ++m_backtracks;
+            }
+            if (budget_spent)
+                break;
+
+            // Nesterov step 与残差（tmp 中为 N γNew）
+            double dlambda = 0.0;
+            double gdotd = 0.0;
+            double res = 0.0;
+            if constexpr (use_kernels) {
+                dlambda = fused[3];
+                gdotd = fused[4];
+                res = std::sqrt(fused[5]) * (static_cast<double>(nc) * nc);
+            } else {
+                for (int i = 0; i < nc; ++i) {
+                    double d = static_cast<double>(gammaNew[i]) - gamma[i];
+                    yNew[i] = static_cast<Real>(gammaNew[i] + Beta * d);
+                    dlambda += d * d;
+                    gdotd += g[i] * d;
+                }
+                res = Res4(op, w);
+            }
+
+            // 更新最优解（只记录位置，不拷贝）
+            if (res < residual) {
+                residual = res;
+                best = BestLocation::GAMMA_NEW;
+            }
+            AtIterationEnd(res, std::sqrt(dlambda), m_iterations);
+            if (residual < m_tolerance)
+                break;
+
+            // 自适应重启：梯度与前进方向夹角为锐角时丢弃动量
+            if (gdotd > 0.0) {
+                yNew = gammaNew;
+                thetaNew = 1.0;
+            }
+
+            // 准备下次迭代
+            L = 0.9 * L;
+            t = 1.0 / L;
+            theta = thetaNew;
+
+            // gamma 交换到 gammaNew 后会在下一轮被覆盖：若最优解仍在其中，此时才拷贝保存
+            if (best == BestLocation::GAMMA) {
+                gamma_hat = gamma;
+                best = BestLocation::GAMMA_HAT;
+            }
+            std::swap(gamma, gammaNew);
+            std::swap(y, yNew);
+            if (best == BestLocation::GAMMA_NEW)
+                best = BestLocation::GAMMA;
+        }
+
+        // 把最优解换入 gamma_hat
+        if (best == BestLocation::GAMMA)
+            std::swap(gamma_hat, gamma);
+        else if (best == BestLocation::GAMMA_NEW)
+            std::swap(gamma_hat, gammaNew);
+    }
+
 } // namespace VSLibRBDynamX
@@ -0,0 +1,79 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Ensemble APGD Solver
+//
+// RBDSolverEnsembleAPGD.h
+//   一次求解许多结构相同的小系统（参数扫描、Monte Carlo、强化学习环境等）。
+//   场景被切成若干段连续的“包”，每包在一个有 GetLaneWidth() 个通道的
+//   RBDEnsembleSchur 上以锁步方式运行 APGD：所有向量按 [约束行][通道] 交错，
+//   迭代中的标量（L、t、theta、残差、最优解等）每通道一份，逐通道独立回溯、重启
+//   与收敛，算法与对每个场景单独调用 RBDSolverAPGD::Solve 相同。
+//   某通道的场景收敛或达到迭代上限后立即写回，并装入本包的下一个场景，
+//   通道不会空等同包中最慢的场景。各包互相独立，在 RBDGetThreadPool() 上并行执行。
+//
+//   相比逐个 Solve，省去了每个小问题的虚调用、工作区分配与标量循环开销，
+//   最内层循环沿场景方向连续，SIMD 通道被多个场景填满。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "RBDIterativeSolverVI.h"
+#include "RBDSystemDescriptor.h"
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// 多场景锁步 APGD 求解器
+    class RBDSolverEnsembleAPGD : public RBDIterativeSolverVI {
+    public:
+        RBDSolverEnsembleAPGD();
+        ~RBDSolverEnsembleAPGD();
+
+        /// 同时求解所有场景（结构须相同：约束顺序、维数、投影类型与变量偏移一致），
+        /// 各自的 λ 经 SetUnknowns 写回，返回所有场景中最大的残差
+        double Solve(const std::vector<RBDSystemDescriptor*>& scenes);
+
+        /// 单个描述器按 1 个场景的集合求解
+        double Solve(RBDSystemDescriptor& sysd);
+
+        /// 所有场景中最大的残差
+        double GetError() const { return m_error; }
+
+        /// 每包的通道数（默认 8；取 SIMD 宽度的整数倍最好，过大时工作区会超出 L1）
+        void SetLaneWidth(int width) { m_lane_width = width < 1 ? 1 : width; }
+        int GetLaneWidth() const { return m_lane_width; }
+
+        /// 上一次求解中场景 s 的数据
+        int GetNumScenes() const { return static_cast<int>(m_residuals.size()); }
+        double GetResidual(int s) const { return m_residuals[s]; }
+        int GetIterations(int s) const { return m_iterations[s]; }
+
+        /// 导出场景 s 的最终 λ
+        void Dump_Lambda(int s, std::vector<double>& temp) const;
+
+    private:
+        struct Pack;
+
+        /// 用一包的通道依次求解场景 [begin, end) 并写回
+        void SolvePack(Pack& pack, const std::vector<RBDSystemDescriptor*>& scenes, int begin, int end);
+
+        int m_lane_width = 8;
+        double m_error = 0.0;
+        std::vector<std::unique_ptr<Pack>> m_packs;  ///< 各包的算子与工作区（跨 Solve 复用）
+        int m_num_rows = 0;                          ///< 每个场景的 λ 长度
+        std::vector<double> m_lambda;                ///< 各场景的最终 λ [场景][行]
+        std::vector<double> m_residuals;
+        std::vector<int> m_iterations;
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
@@ -31,6 +31,9 @@ namespace VSLibRBDynamX {
     - case LCP: all Y_i = R+:  c>=0, l>=0, l*c=0
     - case CCP: Y_i are friction cones
 
+    E is diagonal; its entries are the per-constraint compliances (RBDConstraint::GetCompliance(), zero for
+    rigid constraints), added by the descriptors to the Schur complement product N = D M^-1 D' + E.
+
     For details on the supported types of solvers see ChIterativeSolverVI and the concrete iterative VI solvers.
     */
     class RBDSolverVI : public RBDSolver {
@@ -0,0 +1,63 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Persistent Solver Workspace
+//
+// RBDSolverWorkspace.h
+//   迭代求解器在多次 Solve 之间复用的向量工作区。
+//   - 按历史最大规模（high-water mark）分配：只有 n 超过以往最大值时才重新分配，
+//     规模变小时只改变逻辑长度，不释放也不清零；
+//   - 迭代中“新值变旧值”的更新用 std::swap 交换缓冲区（O(1)），不做整段拷贝。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// APGD 类求解器的持久工作区，按标量类型实例化（double / float）
+    template <class Real>
+    class RBDSolverWorkspace {
+    public:
+        std::vector<Real> gamma;       ///< 当前拉格朗日乘子
+        std::vector<Real> gammaNew;    ///< 下一步拉格朗日乘子
+        std::vector<Real> gamma_hat;   ///< 历史最佳解
+        std::vector<Real> y;           ///< Nesterov 加速辅助变量
+        std::vector<Real> yNew;        ///< 下一步辅助变量
+        std::vector<Real> g;           ///< 当前梯度
+        std::vector<Real> r;           ///< Schur 补右端向量
+        std::vector<Real> tmp;         ///< 中间临时缓冲区
+
+        /// 把所有缓冲区的逻辑长度设为 n。
+        /// 只有 n 超过历史最大值时才重新分配；已有元素的内容保持不变，由求解器负责写入。
+        void Resize(int n) {
+            if (n > m_capacity) {
+                for (auto* v : Buffers())
+                    v->reserve(n);
+                m_capacity = n;
+            }
+            for (auto* v : Buffers())
+                v->resize(n);
+        }
+
+        /// 历史最大规模
+        int GetCapacity() const { return m_capacity; }
+
+    private:
+        std::array<std::vector<Real>*, 8> Buffers() {
+            return { &gamma, &gammaNew, &gamma_hat, &y, &yNew, &g, &r, &tmp };
+        }
+
+        int m_capacity = 0;
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,311 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Compile-time Specialized System Descriptor
+//
+// RBDStaticSystemDescriptor.h
+//   变量和约束的具体类型在编译期已知的系统描述器。
+//   每种类型保存在自己的类型化容器中（std::tuple<std::vector<T*>...>），
+//   质量逆、投影、写回等按类型展开，并用限定名调用（v->T::Foo()）跳过虚函数分派。
+//   类本身为 final，RBDSolverAPGD::SolveSpecialized() 以它实例化时，
+//   描述器的所有调用都被静态绑定，可内联进 APGD 主循环。
+//
+//   RBDVariablesN<DOF> / RBDConstraintN<Dim> 派生类型走定长 std::array 路径，
+//   不构造任何临时 std::vector；RBDVariablesBody 派生类型收集进 RBDBodyMassBatch，
+//   质量逆以 SoA + SIMD 批量计算。
+//
+//   它仍然派生自 RBDSystemDescriptor，可以照常交给 Solve() 或其它只认虚接口的代码。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <cassert>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "RBDSystemDescriptor.h"
+#include "RBDVariablesN.h"
+#include "RBDConstraintN.h"
+#include "RBDConstraintBatches.h"
+#include "RBDBodyMassBatch.h"
+#include "RBDThreadPool.h"
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// 编译期类型列表
+    template <class... Ts>
+    struct RBDTypeList {};
+
+    template <class TVariablesList, class TConstraintsList>
+    class RBDStaticSystemDescriptor;
+
+    /// 编译期特化的系统描述器。
+    ///
+    /// 用法：
+    /// <pre>
+    ///   RBDStaticSystemDescriptor<RBDTypeList<MyRBDVariables>, RBDTypeList<MyRBDConstraint>> sysd;
+    ///   sysd.Add(&var);
+    ///   sysd.Add(&cons);
+    ///   solver.SolveSpecialized(sysd);
+    /// </pre>
+    template <class... TVars, class... TCons>
+    class RBDStaticSystemDescriptor<RBDTypeList<TVars...>, RBDTypeList<TCons...>> final
+        : public RBDSystemDescriptor {
+    public:
+        /// 按静态类型加入变量或约束（编译期路由到对应的类型化容器）
+        template <class T>
+        void Add(T* item) {
+            MarkTopologyChanged();
+            if constexpr ((std::is_same<T, TVars>::value || ...)) {
+                std::get<std::vector<T*>>(m_vars).push_back(item);
+            } else {
+                static_assert((std::is_same<T, TCons>::value || ...),
+                    "RBDStaticSystemDescriptor: type not in the variables/constraints type list");
+                auto& vec = std::get<std::vector<T*>>(m_cons);
+                item->SetIndex(static_cast<int>(vec.size()));
+                vec.push_back(item);
+            }
+        }
+
+        /// 按静态类型移除约束：与同类型容器的末尾约束交换后删除，O(1)
+        template <class T>
+        bool Remove(T* item) {
+            static_assert((std::is_same<T, TCons>::value || ...),
+                "RBDStaticSystemDescriptor: type not in the constraints type list");
+            auto& vec = std::get<std::vector<T*>>(m_cons);
+            const int i = item->GetIndex();
+            if (i < 0 || i >= static_cast<int>(vec.size()) || vec[i] != item)
+                return false;
+            vec[i] = vec.back();
+            vec[i]->SetIndex(i);
+            vec.pop_back();
+            item->SetIndex(-1);
+            MarkTopologyChanged();
+            return true;
+        }
+
+        /// 通过虚接口加入变量：按动态类型路由，类型不在列表中时断言失败
+        void AddVariables(RBDVariables* vars) override {
+            bool added = (TryAdd<TVars>(vars) || ...);
+            assert(added && "RBDStaticSystemDescriptor: variables type not in type list");
+            (void)added;
+        }
+
+        /// 通过虚接口加入约束：按动态类型路由，类型不在列表中时断言失败
+        void AddConstraint(RBDConstraint* constraint) override {
+            bool added = (TryAdd<TCons>(constraint) || ...);
+            assert(added && "RBDStaticSystemDescriptor: constraint type not in type list");
+            (void)added;
+        }
+
+        /// 通过虚接口移除约束：按动态类型路由
+        bool RemoveConstraint(RBDConstraint* constraint) override {
+            return (TryRemove<TCons>(constraint) || ...);
+        }
+
+        /// 所有变量（按类型列表顺序，UpdateCountsAndOffsets 后有效）
+        const std::vector<RBDVariables*>& GetVariables() const override { return m_all_vars; }
+
+        /// 所有约束（按类型列表顺序，UpdateCountsAndOffsets 后有效）
+        const std::vector<RBDConstraint*>& GetConstraints() const override { return m_all_cons; }
+
+        /// 约束批量存储：λ 布局、D^T λ 累加方式与并行装配统计（UpdateCountsAndOffsets 后有效）
+        const RBDConstraintBatches& GetConstraintBatches() const { return m_batches; }
+
+        void UpdateCountsAndOffsets() override {
+            m_all_vars.clear();
+            m_bodies.Clear();
+            m_n_dofs = 0;
+            ForEach(m_vars, [this](auto* v) {
+                using T = std::remove_pointer_t<decltype(v)>;
+                v->SetOffset(m_n_dofs);
+                m_n_dofs += v->T::GetDOF();
+                m_all_vars.push_back(v);
+                if constexpr (std::is_base_of<RBDVariablesBody, T>::value)
+                    m_bodies.Add(v);
+            });
+
+            m_all_cons.clear();
+            ForEach(m_cons, [this](auto* c) { m_all_cons.push_back(c); });
+            m_batches.Setup(m_all_cons);
+            m_batches.Assemble(m_all_cons);
+
+            // 记录 CUSTOM 约束的 λ 偏移（其余约束由批量投影处理）
+            m_custom_offsets.resize(m_all_cons.size());
+            for (std::size_t i = 0; i < m_all_cons.size(); ++i)
+                m_custom_offsets[i] = m_all_cons[i]->GetProjectionType() == RBDProjectionType::CUSTOM
+                    ? m_batches.GetOffset(i) : -1;
+        }
+
+        void UpdateValues() override {
+            m_bodies.UpdateValues(IsIncrementalUpdate());
+            m_batches.AssembleValues(m_all_cons, IsIncrementalUpdate());
+        }
+
+        int CountActiveConstraints() const override { return m_batches.GetNumRows(); }
+
+        int CountActiveVariables() const override { return m_n_dofs; }
+
+        void ConstraintsProject(std::vector<double>& lambda) const override {
+            m_batches.ProjectBatched(lambda.data());
+
+            std::size_t i = 0;
+            ForEach(m_cons, [&](auto* c) {
+                using T = std::remove_pointer_t<decltype(c)>;
+                const int off = m_custom_offsets[i++];
+                if (off < 0)
+                    return;
+                if constexpr (RBDConstraintFixedDim<T>::value > 0) {
+                    typename T::VectorN l;
+                    for (int j = 0; j < T::FixedDim; ++j)
+                        l[j] = lambda[off + j];
+                    c->T::ProjectN(l);
+                    for (int j = 0; j < T::FixedDim; ++j)
+                        lambda[off + j] = l[j];
+                } else {
+                    c->T::Project(RBDSpan<double>(lambda.data() + off, c->T::GetConstraintDim()));
+                }
+            });
+        }
+
+        void GetProjectionLayout(int& bilateral_end, int& unilateral_end) const override {
+            bilateral_end = m_batches.GetEnd(RBDProjectionType::BILATERAL);
+            unilateral_end = m_batches.GetEnd(RBDProjectionType::UNILATERAL);
+        }
+
+        void SchurComplementProduct(const std::vector<double>& lambda,
+            std::vector<double>& result) const override {
+            ComputeVelocities(lambda);
+            result.resize(m_batches.GetNumRows());
+            m_batches.Multiply(m_v.data(), result.data());
+            m_batches.AddComplianceProduct(lambda.data(), result.data());
+        }
+
+        void BuildBiVector(std::vector<double>& b) const override { m_batches.BuildBiVector(b); }
+
+        void BuildSystemMatrix(std::vector<std::vector<double>>& Z,
+            std::vector<double>& d) const override {
+            int n = m_batches.GetNumRows();
+            Z.assign(n, std::vector<double>(n, 0.0));
+            std::vector<double> e(n, 0.0), col;
+            for (int j = 0; j < n; ++j) {
+                e[j] = 1.0;
+                SchurComplementProduct(e, col);
+                for (int i = 0; i < n; ++i)
+                    Z[i][j] = col[i];
+                e[j] = 0.0;
+            }
+            BuildBiVector(d);
+        }
+
+        void SystemProduct(const std::vector<double>& x, std::vector<double>& y) const override {
+            SchurComplementProduct(x, y);
+        }
+
+        void BuildDiVector(std::vector<double>& di) const override { BuildBiVector(di); }
+
+        void SetUnknowns(const std::vector<double>& x) override {
+            ComputeVelocities(x);
+            ParallelForEach(m_vars, [this](auto* v) {
+                using T = std::remove_pointer_t<decltype(v)>;
+                if constexpr (RBDVariablesFixedDOF<T>::value > 0) {
+                    typename T::VectorN state;
+                    for (int d = 0; d < T::FixedDOF; ++d)
+                        state[d] = m_v[v->GetOffset() + d];
+                    v->T::SetStateN(state);
+                } else {
+                    v->T::SetState(RBDSpan<const double>(m_v.data() + v->GetOffset(), v->T::GetDOF()));
+                }
+            });
+        }
+
+    private:
+        template <class T, class TBase>
+        bool TryAdd(TBase* item) {
+            if (auto* typed = dynamic_cast<T*>(item)) {
+                Add(typed);
+                return true;
+            }
+            return false;
+        }
+
+        template <class T>
+        bool TryRemove(RBDConstraint* item) {
+            if (auto* typed = dynamic_cast<T*>(item))
+                return Remove(typed);
+            return false;
+        }
+
+        /// 依次对元组中每个类型化容器的每个元素调用 f
+        template <class TTuple, class F>
+        static void ForEach(const TTuple& containers, F&& f) {
+            std::apply([&](const auto&... vecs) {
+                (ForEachIn(vecs, f), ...);
+            }, containers);
+        }
+
+        template <class TVec, class F>
+        static void ForEachIn(const TVec& vec, F& f) {
+            for (auto* item : vec)
+                f(item);
+        }
+
+        /// 与 ForEach 相同，但每个类型化容器内部在线程池上并行（f 对不同元素不能有写冲突）
+        template <class TTuple, class F>
+        static void ParallelForEach(const TTuple& containers, F&& f) {
+            std::apply([&](const auto&... vecs) {
+                (RBDGetThreadPool().ParallelFor(0, static_cast<int>(vecs.size()), 256, [&](int b, int e) {
+                    for (int i = b; i < e; ++i)
+                        f(vecs[i]);
+                }), ...);
+            }, containers);
+        }
+
+        // m_v = M^{-1} D^T λ：刚体走 SoA 批量，其余按类型静态调用，定长类型走 std::array 路径
+        void ComputeVelocities(const std::vector<double>& lambda) const {
+            m_v.assign(m_n_dofs, 0.0);
+            m_batches.MultiplyTranspose(lambda.data(), m_v.data(), m_acc);
+            m_bodies.Apply(m_v.data());
+            ParallelForEach(m_vars, [this](auto* v) {
+                using T = std::remove_pointer_t<decltype(v)>;
+                const int off = v->GetOffset();
+                if constexpr (std::is_base_of<RBDVariablesBody, T>::value) {
+                    (void)off;  // 已由 m_bodies 批量处理
+                } else if constexpr (RBDVariablesFixedDOF<T>::value > 0) {
+                    typename T::VectorN f, mf;
+                    for (int d = 0; d < T::FixedDOF; ++d)
+                        f[d] = m_v[off + d];
+                    v->T::ComputeMassInverseTimesVectorN(f, mf);
+                    for (int d = 0; d < T::FixedDOF; ++d)
+                        m_v[off + d] = mf[d];
+                } else {
+                    // 原地计算：输入输出是全局速度缓冲中的同一片段
+                    const int dof = v->T::GetDOF();
+                    v->T::ComputeMassInverseTimesVector(RBDSpan<const double>(m_v.data() + off, dof),
+                        RBDSpan<double>(m_v.data() + off, dof));
+                }
+            });
+        }
+
+        std::tuple<std::vector<TVars*>...> m_vars;  ///< 类型化变量容器
+        std::tuple<std::vector<TCons*>...> m_cons;  ///< 类型化约束容器
+        std::vector<RBDVariables*> m_all_vars;      ///< 供虚接口使用的变量列表
+        std::vector<RBDConstraint*> m_all_cons;     ///< 供虚接口使用的约束列表
+        std::vector<int> m_custom_offsets;          ///< CUSTOM 约束的 λ 偏移，其它为 -1
+        RBDConstraintBatches m_batches;             ///< λ 布局、批量投影与 Jacobian 块
+        RBDBodyMassBatch m_bodies;                  ///< 刚体质量逆的 SoA 批量
+        int m_n_dofs = 0;                           ///< 全局速度向量长度
+
+        mutable std::vector<double> m_v;            ///< 全局速度缓冲
+        mutable std::vector<double> m_acc;          ///< D^T λ 的 ACCUMULATE 累加缓冲（见 RBDConstraintBatches::MultiplyTranspose）
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,103 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Step-scoped Arena Allocator
+//
+// RBDStepArena.h
+//   只在一个仿真步内有效的线性（bump）分配器，用于每步创建、每步销毁的
+//   临时对象（典型的是接触约束）。
+//   - 分配是在当前内存块上移动指针，O(1)，不调用 malloc；
+//   - Reset() 在步末把所有通道的指针拨回起点，内存块保留给下一步复用；
+//   - 分为若干“通道”（lane），每个线程使用自己的通道时无需加锁，
+//     避免多线程生成接触时的 malloc 竞争。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// 步作用域的多通道 bump 分配器
+    class RBDStepArena {
+    public:
+        /// @param chunk_size 每个内存块的默认字节数
+        /// @param num_lanes  通道数（通常等于生成接触的线程数）
+        explicit RBDStepArena(std::size_t chunk_size = 64 * 1024, int num_lanes = 1);
+        ~RBDStepArena();
+
+        RBDStepArena(const RBDStepArena&) = delete;
+        RBDStepArena& operator=(const RBDStepArena&) = delete;
+
+        /// 设置通道数（会先 Reset，不能在分配过程中调用）
+        void SetNumLanes(int num_lanes);
+        int GetNumLanes() const { return static_cast<int>(m_lanes.size()); }
+
+        /// 在通道 lane 上分配 bytes 字节、按 align 对齐的原始内存
+        void* Allocate(std::size_t bytes, std::size_t align, int lane = 0);
+
+        /// 在通道 lane 上构造一个 T；若 T 需要析构，析构函数在 Reset() 时调用
+        template <class T, class... Args>
+        T* Create(int lane, Args&&... args) {
+            void* mem = Allocate(sizeof(T), alignof(T), lane);
+            T* obj = new (mem) T(std::forward<Args>(args)...);
+            if (!std::is_trivially_destructible<T>::value)
+                m_lanes[lane].dtors.push_back({ obj, &Destroy<T> });
+            return obj;
+        }
+
+        /// 在通道 lane 上分配 n 个 T 的数组（只用于平凡可析构的类型，如 Jacobian 数据）
+        template <class T>
+        T* AllocateArray(std::size_t n, int lane = 0) {
+            static_assert(std::is_trivially_destructible<T>::value, "AllocateArray requires trivially destructible T");
+            return static_cast<T*>(Allocate(n * sizeof(T), alignof(T), lane));
+        }
+
+        /// 步末释放：析构登记过的对象，所有通道的指针回到起点，内存块保留
+        void Reset();
+
+        /// 当前已占用的字节数（所有通道）
+        std::size_t GetBytesUsed() const;
+
+        /// 已向系统申请的字节数（所有通道）
+        std::size_t GetBytesReserved() const;
+
+    private:
+        struct Chunk {
+            std::unique_ptr<unsigned char[]> data;
+            std::size_t size;
+        };
+
+        struct DtorRecord {
+            void* obj;
+            void (*destroy)(void*);
+        };
+
+        /// 每个通道独占一条缓存行，避免不同线程之间的伪共享
+        struct alignas(64) Lane {
+            std::vector<Chunk> chunks;
+            std::size_t current = 0;   ///< 当前使用的内存块
+            std::size_t used = 0;      ///< 当前内存块已使用的字节
+            std::vector<DtorRecord> dtors;
+        };
+
+        template <class T>
+        static void Destroy(void* p) { static_cast<T*>(p)->~T(); }
+
+        std::size_t m_chunk_size;
+        std::vector<Lane> m_lanes;
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
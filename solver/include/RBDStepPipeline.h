@@ -0,0 +1,102 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Pipelined Multi-Island Step Executor
+//
+// RBDStepPipeline.h
+//   把一个仿真步内多个相互独立的岛（每个岛一个 RBDSystemDescriptor）
+//   组织成三级流水线：装配 → 求解 → 写回。
+//     A(k)：宿主的 prepare 回调 + Jacobian/偏置装配（岛的拓扑未变时只刷新数值）
+//     S(k)：APGD 迭代（每个岛有自己的求解器工作区）
+//     W(k)：SetUnknowns 写回 + 宿主的 finish 回调
+//   依赖关系 A(k)→S(k)→W(k)，且同一级按岛的顺序执行（A(k)→A(k+1) 等），
+//   因此岛 k+1 的装配与岛 k 的求解、岛 k-1 的写回在 RBDGetThreadPool() 上重叠，
+//   装配延迟被求解掩盖。整张图用 RBDTaskGraph 表达。
+//
+//   同一级的回调永远不会并发；不同级的回调可能同时作用于不同的岛，
+//   宿主需保证不同岛之间没有共享的可写状态。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "RBDSolverAPGD.h"
+#include "RBDThreadPool.h"
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// 单个岛在上一步中的统计
+    struct RBDPipelineIslandStats {
+        double assemble_seconds = 0.0;   ///< 装配阶段耗时（含 prepare 回调）
+        double solve_seconds = 0.0;      ///< 求解阶段耗时
+        double writeback_seconds = 0.0;  ///< 写回阶段耗时（含 finish 回调）
+        double residual = 0.0;           ///< 求解残差
+        int iterations = 0;              ///< 迭代轮数
+        bool budget_exceeded = false;    ///< 求解是否因时间预算用完而提前结束
+    };
+
+    /// 多岛流水线步进器
+    class RBDStepPipeline {
+    public:
+        /// 宿主回调：prepare 可在装配前为该岛更新接触、填充描述器，finish 可在写回后同步宿主数据
+        using Callback = std::function<void()>;
+
+        RBDStepPipeline() = default;
+        RBDStepPipeline(const RBDStepPipeline&) = delete;
+        RBDStepPipeline& operator=(const RBDStepPipeline&) = delete;
+
+        /// 求解参数模板：每步开始时拷贝到各岛的求解器。
+        /// 时间预算与单独 Solve 一致，覆盖装配与求解（不含 prepare 回调及等待前一个岛的时间）
+        RBDSolverAPGD& GetSolverSettings() { return m_settings; }
+
+        /// 加入一个岛，返回其编号；prepare 在装配前、finish 在写回后调用（均可为空）
+        int AddIsland(RBDSystemDescriptor* sysd, Callback prepare = Callback(), Callback finish = Callback());
+
+        /// 移除所有岛
+        void ClearIslands();
+
+        int GetNumIslands() const { return static_cast<int>(m_islands.size()); }
+
+        /// 执行一步：按流水线装配、求解、写回所有岛，返回时全部完成
+        void Step();
+
+        /// 上一步中岛 k 的统计
+        const RBDPipelineIslandStats& GetIslandStats(int k) const { return m_islands[k]->stats; }
+
+        /// 岛 k 的求解器（上一步的 λ 可经 Dump_Lambda 取出）
+        const RBDSolverAPGD& GetIslandSolver(int k) const { return m_islands[k]->solver; }
+
+        /// 上一步的总耗时
+        double GetStepSeconds() const { return m_step_seconds; }
+
+    private:
+        struct Island {
+            RBDSystemDescriptor* sysd = nullptr;
+            Callback prepare;
+            Callback finish;
+            RBDSolverAPGD solver;          ///< 该岛独立的工作区（跨步复用）
+            RBDPipelineIslandStats stats;
+            double budget_assembly = 0.0;  ///< 求解器装配耗时（不含 prepare 回调），计入该岛的时间预算
+        };
+
+        void Assemble(Island& island);
+        void SolveIsland(Island& island);
+        void WriteBack(Island& island);
+
+        RBDSolverAPGD m_settings;
+        std::vector<std::unique_ptr<Island>> m_islands;
+        RBDTaskGraph m_graph;
+        double m_step_seconds = 0.0;
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
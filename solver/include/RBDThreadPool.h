@@ -0,0 +1,192 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Work-stealing Thread Pool
+//
+// RBDThreadPool.h
+//   不依赖任何第三方库的工作窃取线程池：
+//   - 每个工作线程有自己的任务双端队列，自己从队尾取，空闲时从其它线程的队首窃取；
+//   - 等待任务组（RBDTaskGroup）的线程不会空等，而是一起执行队列中属于该组的任务，
+//     因此在任务内部再调用 ParallelFor 也不会死锁；
+//   - 线程数可配置（包含调用线程），可选把工作线程绑定到固定 CPU 核。
+//
+//   RBDTaskGraph 在线程池之上表达带依赖的任务图：前驱全部完成的任务才被提交，
+//   用于多岛的流水线步进（见 RBDStepPipeline）。
+//
+//   求解器中的 Schur 补乘积、刚体质量逆、APGD 向量内核等通过 RBDGetThreadPool()
+//   取得全局线程池；线程数为 1 时这些路径退化为串行调用，没有额外开销。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// 一组需要共同等待的任务（计数器）
+    class RBDTaskGroup {
+    public:
+        RBDTaskGroup() : m_pending(0) {}
+        RBDTaskGroup(const RBDTaskGroup&) = delete;
+        RBDTaskGroup& operator=(const RBDTaskGroup&) = delete;
+
+        /// 尚未完成的任务数
+        int GetPending() const { return m_pending.load(std::memory_order_acquire); }
+
+    private:
+        friend class RBDThreadPool;
+        std::atomic<int> m_pending;
+    };
+
+    /// 工作窃取线程池
+    class RBDThreadPool {
+    public:
+        /// @param num_threads 线程总数（含调用线程），0 表示 std::thread::hardware_concurrency()
+        explicit RBDThreadPool(int num_threads = 0);
+        ~RBDThreadPool();
+
+        RBDThreadPool(const RBDThreadPool&) = delete;
+        RBDThreadPool& operator=(const RBDThreadPool&) = delete;
+
+        /// 重新设置线程总数（会停止并重建工作线程，不能在任务执行期间调用）
+        void SetNumThreads(int num_threads);
+        int GetNumThreads() const { return static_cast<int>(m_queues.size()); }
+
+        /// 是否把第 i 个工作线程绑定到第 i 个逻辑 CPU（调用线程本身不绑定）；
+        /// 改变设置会重建工作线程
+        void SetPinning(bool pin);
+        bool GetPinning() const { return m_pin; }
+
+        /// 提交一个属于 group 的任务
+        void Run(RBDTaskGroup& group, std::function<void()> task);
+
+        /// 提交一个只由空闲工作线程执行的任务：任何线程在 Wait 中都不会取走它，
+        /// 适合不应占用调用线程的长任务（如异步求解）。
+        /// 没有工作线程（线程总数为 1）时在当前线程上立即执行
+        void RunOnWorker(RBDTaskGroup& group, std::function<void()> task);
+
+        /// 等待 group 中所有任务完成；等待期间当前线程也执行队列中属于 group 的任务
+        /// （不执行其它组的任务，以免把它们嵌套在本组的等待中）
+        void Wait(RBDTaskGroup& group);
+
+        /// 并行执行 f(b, e)，[begin, end) 被切成不小于 grain 的若干块。
+        /// 线程数为 1 或区间不足两块时直接在当前线程调用 f(begin, end)。
+        template <class F>
+        void ParallelFor(int begin, int end, int grain, F&& f);
+
+        /// 当前线程在本线程池中的编号：调用线程（外部线程）为 0，工作线程为 1..N-1
+        int GetThreadIndex() const;
+
+    private:
+        struct Task {
+            std::function<void()> fn;
+            RBDTaskGroup* group;
+        };
+
+        struct alignas(64) Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void Start(int num_threads);
+        void Stop();
+        void WorkerLoop(int index);
+        /// 取一个任务执行：group 为空时取任意任务（空闲的工作线程），否则只取属于 group 的任务（Wait）
+        bool TryRunOne(int index, const RBDTaskGroup* group);
+        /// 从队尾（back）或队首取出第一个属于 group 的任务（group 为空时不限）
+        bool Take(Queue& q, bool back, const RBDTaskGroup* group, Task& task);
+        bool Pop(int index, const RBDTaskGroup* group, Task& task);
+        bool Steal(int thief, const RBDTaskGroup* group, Task& task);
+        bool PopWorkerOnly(Task& task);
+        static void Execute(Task& task);
+
+        std::vector<std::unique_ptr<Queue>> m_queues;  ///< 每个线程一个队列，0 号属于外部调用线程
+        Queue m_worker_queue;                          ///< 只由工作线程取用的任务（RunOnWorker）
+        std::vector<std::thread> m_workers;
+        std::atomic<int> m_queued;                     ///< 所有队列中尚未取走的任务数
+        std::atomic<unsigned> m_next;                  ///< 外部线程提交任务时轮转选择队列
+        std::atomic<bool> m_stop;
+        std::mutex m_sleep_mutex;
+        std::condition_variable m_sleep_cv;
+        bool m_pin;
+    };
+
+    /// 全局线程池（首次调用时以硬件线程数创建）
+    RBDThreadPool& RBDGetThreadPool();
+
+    /// 带依赖关系的任务图（有向无环），可反复执行
+    class RBDTaskGraph {
+    public:
+        /// 加入一个任务，返回其编号
+        int AddTask(std::function<void()> fn);
+
+        /// 任务 after 在任务 before 完成后才开始
+        void AddDependency(int before, int after);
+
+        int GetNumTasks() const { return static_cast<int>(m_nodes.size()); }
+
+        /// 清空所有任务与依赖
+        void Clear();
+
+        /// 在 pool 上执行整张图并等待完成（调用线程参与执行）；
+        /// 线程池只有 1 个线程时按拓扑顺序串行执行
+        void Run(RBDThreadPool& pool);
+
+    private:
+        struct Node {
+            std::function<void()> fn;
+            std::vector<int> successors;
+            int num_deps = 0;
+        };
+
+        void Submit(RBDThreadPool& pool, RBDTaskGroup& group, int index);
+
+        std::vector<Node> m_nodes;
+        std::unique_ptr<std::atomic<int>[]> m_remaining;  ///< 执行期间各任务尚未完成的前驱数
+    };
+
+    /// @} VSLibRBDynamX_solver
+
+    // -------------------------------------------------------------------------
+    // 模板实现
+    // -------------------------------------------------------------------------
+
+    template <class F>
+    void RBDThreadPool::ParallelFor(int begin, int end, int grain, F&& f) {
+        const int n = end - begin;
+        if (grain < 1)
+            grain = 1;
+        const int threads = GetNumThreads();
+        if (threads <= 1 || n < 2 * grain) {
+            if (n > 0)
+                f(begin, end);
+            return;
+        }
+
+        // 每个线程约 4 块，便于负载不均时窃取
+        int chunk = (n + 4 * threads - 1) / (4 * threads);
+        if (chunk < grain)
+            chunk = grain;
+
+        RBDTaskGroup group;
+        for (int b = begin + chunk; b < end; b += chunk) {
+            const int e = b + chunk < end ? b + chunk : end;
+            Run(group, [&f, b, e]() { f(b, e); });
+        }
+        f(begin, begin + chunk);
+        Wait(group);
+    }
+
+} // namespace VSLibRBDynamX
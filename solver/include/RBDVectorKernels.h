@@ -0,0 +1,105 @@
+﻿// =============================================================================
+// VSLibRBDynamX – Runtime-dispatched Vector Kernels
+//
+// RBDVectorKernels.h
+//   APGD 等迭代求解器主循环中的向量运算（axpy、点积、范数以及若干融合更新），
+//   每个内核有 scalar / SSE2 / AVX2 / AVX-512 四个实现，按 RBDGetSimdLevel()
+//   在运行时选择（见 RBDSimd.h），不依赖编译期 -march。
+//
+//   各实现的求和顺序不同，AVX2 / AVX-512 的 Fmadd 为融合乘加（一次舍入），
+//   scalar / SSE2 为先乘后加，因此结果只在舍入误差范围内一致：
+//   test_vector_kernels 按 |差| ≤ 1e-12 (1 + |参考值|) (1 + n) 检查各级别与 scalar。
+//   需要逐位一致时可用 RBDSetSimdLevel() 把所有机器限制到同一级别。
+//
+// Copyright (c) 2025 Zijian Zhang
+// All rights reserved.
+//
+// =============================================================================
+
+#pragma once
+
+#include "RBDSimd.h"
+
+namespace VSLibRBDynamX {
+
+    /// @addtogroup VSLibRBDynamX_solver
+    /// @{
+
+    /// 一组向量内核（函数指针表），同一张表内的实现属于同一指令集级别
+    struct RBDVectorKernels {
+        RBDSimdLevel level;  ///< 本表对应的指令集级别
+
+        /// x · y
+        double (*Dot)(int n, const double* x, const double* y);
+
+        /// ||x||_2
+        double (*Norm)(int n, const double* x);
+
+        /// ||x - y||_2^2
+        double (*DistSquared)(int n, const double* x, const double* y);
+
+        /// y += a x
+        void (*Axpy)(int n, double a, const double* x, double* y);
+
+        /// w = x + a y（w 可以与 x 或 y 同址）
+        void (*Waxpy)(int n, double* w, const double* x, double a, const double* y);
+
+        /// 梯度与目标值：g += r，返回 0.5 y · (g + r)（即 f(y) = 0.5 y'Ny + y'r，调用前 g = Ny）
+        double (*GradientObjective)(int n, double* g, const double* r, const double* y);
+
+        // ---- 融合内核：每个元素只读写一次，按 λ 的投影分段调用 ----
+
+        /// w = x + a y，clamp 为 true 时再投影到 w ≥ 0（梯度步 + 单边投影）
+        void (*ProjectedWaxpy)(int n, bool clamp, double* w, const double* x, double a, const double* y);
+
+        /// APGD 一次迭代中 N x 算出之后的全部逐元素工作，一遍完成：
+        ///   回溯判据 d = x - y：out[0] = Σ x (0.5 Nx + r)，out[1] = Σ g d，out[2] = Σ d d
+        ///   Nesterov 外推 e = x - x_old：y_new = x + beta e，out[3] = Σ e e，out[4] = Σ g e
+        ///   残差点 p = x - gdiff (Nx + r)：
+        ///     mode 0（无投影）/ 1（投影到 ≥ 0）时 out[5] = Σ (x - proj(p))^2；
+        ///     mode 2 时 p 写入 res_point，由调用者投影并累加，out[5] = 0
+        void (*FusedUpdate)(int n, int mode, const double* x, const double* x_old, const double* y,
+            const double* Nx, const double* r, const double* g, double beta, double gdiff,
+            double* y_new, double* res_point, double out[6]);
+
+        /// n 个接触的摩擦锥投影，输入为 SoA 布局的法向/切向 λ 与摩擦系数；
+        /// 每 2/4/8 个接触一组，用掩码混合代替分支（结果与 RBDProjectFrictionCone 逐个计算一致）
+        void (*ProjectFrictionCone)(int n, const double* mu, double* fn, double* t1, double* t2);
+
+        // ---- 通道内核：多个同结构问题按 [行][通道] 交错存放（元素 (i, s) 位于 i * lanes + s），
+        //      沿通道方向向量化；标量参数与求和结果每通道一份，各通道的和按行顺序累加 ----
+
+        /// 按行压缩（CSR）的稀疏矩阵乘向量，矩阵值逐通道不同、结构相同：
+        ///   y[i * lanes + s] = Σ_{e ∈ [ptr[i], ptr[i+1])} a[e * lanes + s] * x[col[e] * lanes + s]，i ∈ [0, rows)
+        void (*LaneCsrMultiply)(int rows, int lanes, const int* ptr, const int* col, const double* a,
+            const double* x, double* y);
+
+        /// w = x + a[s] y（逐通道系数，w 可以与 x 或 y 同址）
+        void (*LaneWaxpy)(int rows, int lanes, double* w, const double* x, const double* a, const double* y);
+
+        /// 逐通道的 GradientObjective：g += r，out[s] = 0.5 Σ y (g + r)
+        void (*LaneGradientObjective)(int rows, int lanes, double* g, const double* r, const double* y, double* out);
+
+        /// 逐通道的回溯判据，d = x - y，out[k * lanes + s] 为通道 s 的第 k 个和：
+        ///   k = 0: Σ x (0.5 Nx + r)，k = 1: Σ g d，k = 2: Σ d d
+        void (*LaneBacktrackTerms)(int rows, int lanes, const double* x, const double* y, const double* Nx,
+            const double* r, const double* g, double* out);
+
+        /// 逐通道的 Nesterov 外推（beta 每通道一个），d = x - x_old，y_new = x + beta[s] d，
+        /// out[k * lanes + s] 为通道 s 的第 k 个和：k = 0: Σ d d，k = 1: Σ g d
+        void (*LaneExtrapolate)(int rows, int lanes, const double* x, const double* x_old, const double* beta,
+            const double* g, double* y_new, double* out);
+
+        /// out[s] = Σ (x - y)^2
+        void (*LaneDistSquared)(int rows, int lanes, const double* x, const double* y, double* out);
+    };
+
+    /// 指定级别的内核表（高于硬件能力时退回到 RBDDetectSimdLevel()）
+    const RBDVectorKernels& RBDGetVectorKernels(RBDSimdLevel level);
+
+    /// 当前生效级别（RBDGetSimdLevel()）的内核表
+    inline const RBDVectorKernels& RBDGetVectorKernels() { return RBDGetVectorKernels(RBDGetSimdLevel()); }
+
+    /// @} VSLibRBDynamX_solver
+
+} // namespace VSLibRBDynamX
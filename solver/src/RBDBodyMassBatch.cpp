@@ -0,0 +1,178 @@
+﻿// =============================================================================
+//  RBDBodyMassBatch.cpp
+//
+//  SoA mass-inverse application for 6-DOF rigid bodies with scalar,
+//  AVX2 and AVX-512 kernels selected at run time.
+// =============================================================================
+
+#include "RBDBodyMassBatch.h"
+#include "RBDSimd.h"
+#include "RBDThreadPool.h"
+
+#include <algorithm>
+
+#if RBD_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VSLibRBDynamX {
+
+    namespace {
+
+        // 并行分块的刚体数：固定且为 8 的倍数（AVX2 / AVX-512 宽度）。
+        // 块边界与线程数无关，SIMD 主体与标量尾部处理的刚体也就与线程数无关，结果逐位一致
+        constexpr int kApplyBlock = 512;
+
+        // 每次 gather 到栈上的刚体数：8 的倍数且整除 kApplyBlock，
+        // 因此标量尾部只出现在最后一块的最后一包，与整块一次 gather 的结果逐位一致
+        constexpr int kApplyPack = 64;
+
+        // 对 [begin, end) 范围内的刚体计算 x = M^{-1} x（x 为 6 个分量数组）
+        // 运算顺序与 RBDVariablesBody::ComputeMassInverseTimesVectorN 一致。SIMD 版本同样先乘后加、
+        // 不用 FMA（构建时关闭浮点收缩），各级别与逐个虚调用的结果逐位相同
+        void ApplyScalar(int begin, int end, const double* im, const double* const* I, double* const* x) {
+            for (int i = begin; i < end; ++i) {
+                x[0][i] *= im[i];
+                x[1][i] *= im[i];
+                x[2][i] *= im[i];
+                const double t0 = x[3][i], t1 = x[4][i], t2 = x[5][i];
+                x[3][i] = I[0][i] * t0 + I[1][i] * t1 + I[2][i] * t2;
+                x[4][i] = I[3][i] * t0 + I[4][i] * t1 + I[5][i] * t2;
+                x[5][i] = I[6][i] * t0 + I[7][i] * t1 + I[8][i] * t2;
+            }
+        }
+
+#if RBD_SIMD_X86
+        RBD_TARGET_AVX2
+        void ApplyAvx2(int n, const double* im, const double* const* I, double* const* x) {
+            int i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const __m256d m = _mm256_loadu_pd(im + i);
+                for (int d = 0; d < 3; ++d)
+                    _mm256_storeu_pd(x[d] + i, _mm256_mul_pd(m, _mm256_loadu_pd(x[d] + i)));
+
+                const __m256d t0 = _mm256_loadu_pd(x[3] + i);
+                const __m256d t1 = _mm256_loadu_pd(x[4] + i);
+                const __m256d t2 = _mm256_loadu_pd(x[5] + i);
+                for (int r = 0; r < 3; ++r) {
+                    __m256d w = _mm256_mul_pd(_mm256_loadu_pd(I[3 * r] + i), t0);
+                    w = _mm256_add_pd(w, _mm256_mul_pd(_mm256_loadu_pd(I[3 * r + 1] + i), t1));
+                    w = _mm256_add_pd(w, _mm256_mul_pd(_mm256_loadu_pd(I[3 * r + 2] + i), t2));
+                    _mm256_storeu_pd(x[3 + r] + i, w);
+                }
+            }
+            ApplyScalar(i, n, im, I, x);
+        }
+
+        RBD_TARGET_AVX512
+        void ApplyAvx512(int n, const double* im, const double* const* I, double* const* x) {
+            int i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const __m512d m = _mm512_loadu_pd(im + i);
+                for (int d = 0; d < 3; ++d)
+                    _mm512_storeu_pd(x[d] + i, _mm512_mul_pd(m, _mm512_loadu_pd(x[d] + i)));
+
+                const __m512d t0 = _mm512_loadu_pd(x[3] + i);
+                const __m512d t1 = _mm512_loadu_pd(x[4] + i);
+                const __m512d t2 = _mm512_loadu_pd(x[5] + i);
+                for (int r = 0; r < 3; ++r) {
+                    __m512d w = _mm512_mul_pd(_mm512_loadu_pd(I[3 * r] + i), t0);
+                    w = _mm512_add_pd(w, _mm512_mul_pd(_mm512_loadu_pd(I[3 * r + 1] + i), t1));
+                    w = _mm512_add_pd(w, _mm512_mul_pd(_mm512_loadu_pd(I[3 * r + 2] + i), t2));
+                    _mm512_storeu_pd(x[3 + r] + i, w);
+                }
+            }
+            ApplyScalar(i, n, im, I, x);
+        }
+#endif
+
+    } // namespace
+
+    void RBDBodyMassBatch::Clear() {
+        m_bodies.clear();
+        m_stamps.clear();
+        m_offset.clear();
+        m_inv_mass.clear();
+        for (auto& c : m_inv_inertia)
+            c.clear();
+    }
+
+    void RBDBodyMassBatch::Add(const RBDVariablesBody* body) {
+        m_bodies.push_back(body);
+        m_stamps.push_back(body->GetStamp());
+        m_offset.push_back(body->GetOffset());
+        m_inv_mass.push_back(body->GetBodyInvMass());
+        const auto& I = body->GetBodyInvInertia();
+        for (int k = 0; k < 9; ++k)
+            m_inv_inertia[k].push_back(I[k]);
+    }
+
+    void RBDBodyMassBatch::UpdateValues(bool incremental) {
+        RBDGetThreadPool().ParallelFor(0, GetNumBodies(), 1024, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                const unsigned long long stamp = m_bodies[i]->GetStamp();
+                if (incremental && stamp == m_stamps[i])
+                    continue;
+                m_stamps[i] = stamp;
+                m_inv_mass[i] = m_bodies[i]->GetBodyInvMass();
+                const auto& I = m_bodies[i]->GetBodyInvInertia();
+                for (int k = 0; k < 9; ++k)
+                    m_inv_inertia[k][i] = I[k];
+            }
+        });
+    }
+
+    void RBDBodyMassBatch::Apply(double* v) const {
+        const int n = GetNumBodies();
+        if (n == 0)
+            return;
+
+        // 刚体之间互不相关：按固定大小的块并行，每块独立 gather / 计算 / scatter。
+        // 不直接按刚体下标 ParallelFor：那样块大小随线程数变化，标量尾部落在哪些刚体上也随之变化
+        const RBDSimdLevel level = RBDGetSimdLevel();
+        const int blocks = (n + kApplyBlock - 1) / kApplyBlock;
+        RBDGetThreadPool().ParallelFor(0, blocks, 1, [&](int first, int last) {
+            for (int b = first; b < last; ++b)
+                ApplyRange(b * kApplyBlock, std::min(n, (b + 1) * kApplyBlock), level, v);
+        });
+    }
+
+    void RBDBodyMassBatch::ApplyRange(int begin, int end, RBDSimdLevel level, double* v) const {
+        double soa[6][kApplyPack];
+        double* x[6];
+        for (int d = 0; d < 6; ++d)
+            x[d] = soa[d];
+
+        for (int first = begin; first < end; first += kApplyPack) {
+            const int n = std::min(kApplyPack, end - first);
+
+            // gather：AoS 片段 -> SoA 分量
+            for (int i = 0; i < n; ++i) {
+                const double* p = v + m_offset[first + i];
+                for (int d = 0; d < 6; ++d)
+                    x[d][i] = p[d];
+            }
+
+            const double* I[9];
+            for (int k = 0; k < 9; ++k)
+                I[k] = m_inv_inertia[k].data() + first;
+            const double* im = m_inv_mass.data() + first;
+
+            switch (level) {
+#if RBD_SIMD_X86
+            case RBDSimdLevel::AVX512: ApplyAvx512(n, im, I, x); break;
+            case RBDSimdLevel::AVX2: ApplyAvx2(n, im, I, x); break;
+#endif
+            default: ApplyScalar(0, n, im, I, x); break;
+            }
+
+            // scatter：SoA 分量 -> AoS 片段
+            for (int i = 0; i < n; ++i) {
+                double* p = v + m_offset[first + i];
+                for (int d = 0; d < 6; ++d)
+                    p[d] = x[d][i];
+            }
+        }
+    }
+
+} // namespace VSLibRBDynamX
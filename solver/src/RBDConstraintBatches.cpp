@@ -0,0 +1,415 @@
+﻿// =============================================================================
+//  RBDConstraintBatches.cpp
+//
+//  Bucketing of constraints by projection type, batched projection of the
+//  global multiplier vector and flat storage of the constraint Jacobian blocks.
+// =============================================================================
+
+#include "RBDConstraintBatches.h"
+#include "RBDVectorKernels.h"
+#include "RBDThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <mutex>
+
+namespace VSLibRBDynamX {
+
+    namespace {
+
+        // 锥投影每次转置的接触数：AVX-512 宽度（8）的整数倍，SoA 缓冲放在栈上。
+        // 余数接触仍落在整个区间的末尾，与一次性转置全部接触的结果逐位一致
+        constexpr int kConePack = 64;
+
+    } // namespace
+
+    void RBDConstraintBatches::Setup(const std::vector<RBDConstraint*>& cons) {
+        // 第一遍：统计每种类型的行数
+        int rows[NUM_TYPES] = {};
+        for (auto* c : cons)
+            rows[static_cast<int>(c->GetProjectionType())] += c->GetConstraintDim();
+
+        m_begin[0] = 0;
+        for (int t = 0; t < NUM_TYPES; ++t)
+            m_begin[t + 1] = m_begin[t] + rows[t];
+        m_num_rows = m_begin[NUM_TYPES];
+
+        // 第二遍：在各自类型的区间内按添加顺序分配偏移
+        int cursor[NUM_TYPES];
+        for (int t = 0; t < NUM_TYPES; ++t)
+            cursor[t] = m_begin[t];
+
+        m_offsets.resize(cons.size());
+        m_dims.resize(cons.size());
+        m_custom.clear();
+        m_custom_offsets.clear();
+        m_cone_mu.clear();
+        for (std::size_t i = 0; i < cons.size(); ++i) {
+            int t = static_cast<int>(cons[i]->GetProjectionType());
+            m_dims[i] = cons[i]->GetConstraintDim();
+            m_offsets[i] = cursor[t];
+            cons[i]->SetOffset(m_offsets[i]);
+            cursor[t] += m_dims[i];
+            if (cons[i]->GetProjectionType() == RBDProjectionType::CUSTOM) {
+                m_custom.push_back(cons[i]);
+                m_custom_offsets.push_back(m_offsets[i]);
+            } else if (cons[i]->GetProjectionType() == RBDProjectionType::FRICTION_CONE) {
+                assert(m_dims[i] == 3 && "FRICTION_CONE constraints must have 3 rows");
+                m_cone_mu.push_back(cons[i]->GetFrictionCoefficient());
+            }
+        }
+    }
+
+    void RBDConstraintBatches::Assemble(const std::vector<RBDConstraint*>& cons) {
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point t0 = Clock::now();
+        AssembleStructure(cons);
+        AssembleValues(cons);
+        m_assembly_seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    }
+
+    void RBDConstraintBatches::AssembleStructure(const std::vector<RBDConstraint*>& cons) {
+        const int n = static_cast<int>(cons.size());
+        RBDThreadPool& pool = RBDGetThreadPool();
+
+        // 第一遍（并行）：每个约束的变量槽数与 Jacobian 块大小，暂存在 [i + 1]
+        m_jac_begin.resize(n + 1);
+        m_slot_begin.resize(n + 1);
+        m_jac_begin[0] = 0;
+        m_slot_begin[0] = 0;
+        pool.ParallelFor(0, n, 1024, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                int slots = 0, cols = 0;
+                for (auto* v : cons[i]->GetVariables()) {
+                    ++slots;
+                    cols += v->GetDOF();
+                }
+                m_slot_begin[i + 1] = slots;
+                m_jac_begin[i + 1] = m_dims[i] * cols;
+            }
+        });
+
+        // 前缀和（串行）：各约束在扁平数组中的位置
+        for (int i = 0; i < n; ++i) {
+            m_slot_begin[i + 1] += m_slot_begin[i];
+            m_jac_begin[i + 1] += m_jac_begin[i];
+        }
+        const int ns = m_slot_begin[n];
+        m_slot_offset.resize(ns);
+        m_slot_dof.resize(ns);
+        m_slot_con.resize(ns);
+        m_slot_col.resize(ns);
+        m_jac.resize(m_jac_begin[n]);
+        m_bias.assign(m_num_rows, 0.0);
+        m_compliance.assign(m_num_rows, 0.0);
+        m_stamps.assign(n, 0);
+
+        // 第二遍（并行）：各约束写入互不重叠的变量槽
+        pool.ParallelFor(0, n, 1024, [&](int begin, int end) {
+            StructureRange(cons, begin, end);
+        });
+
+        BuildTranspose();
+    }
+
+    void RBDConstraintBatches::AssembleValues(const std::vector<RBDConstraint*>& cons, bool incremental) {
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point t0 = Clock::now();
+        const int n = static_cast<int>(cons.size());
+        assert(n + 1 == static_cast<int>(m_jac_begin.size()) && "AssembleValues requires AssembleStructure");
+        RBDThreadPool& pool = RBDGetThreadPool();
+
+        // 各约束写入互不重叠的 Jacobian 块、偏置行与摩擦系数（并行）。
+        // 偏置只写各约束的第一行，其余行在 AssembleStructure 中已清零
+        // 统计按块在局部累计，块结束时加锁并入所在线程的槽：
+        // 非线程池线程（调用线程及在 Wait 中帮忙的外部线程）共用 0 号槽，不能直接写
+        m_assembly_stats.assign(pool.GetNumThreads(), RBDAssemblyThreadStats());
+        std::mutex stats_mutex;
+        pool.ParallelFor(0, n, 256, [&](int begin, int end) {
+            const RBDAssemblyThreadStats chunk = AssembleRange(cons, begin, end, incremental);
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            RBDAssemblyThreadStats& stats = m_assembly_stats[pool.GetThreadIndex()];
+            stats.constraints += chunk.constraints;
+            stats.jacobian_entries += chunk.jacobian_entries;
+            stats.seconds += chunk.seconds;
+        });
+        m_num_assembled = 0;
+        for (const auto& s : m_assembly_stats)
+            m_num_assembled += s.constraints;
+        m_has_compliance = std::any_of(m_compliance.begin(), m_compliance.end(), [](double e) { return e != 0.0; });
+        m_assembly_seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    }
+
+    void RBDConstraintBatches::StructureRange(const std::vector<RBDConstraint*>& cons, int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            // 变量槽：记录每个关联变量在全局速度向量中的位置
+            int s = m_slot_begin[i], cols = 0;
+            for (auto* v : cons[i]->GetVariables()) {
+                m_slot_offset[s] = v->GetOffset();
+                m_slot_dof[s] = v->GetDOF();
+                m_slot_con[s] = i;
+                m_slot_col[s] = cols;
+                cols += m_slot_dof[s];
+                ++s;
+            }
+        }
+    }
+
+    RBDAssemblyThreadStats RBDConstraintBatches::AssembleRange(const std::vector<RBDConstraint*>& cons,
+        int begin, int end, bool incremental) {
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point t0 = Clock::now();
+        const int cone_begin = GetBegin(RBDProjectionType::FRICTION_CONE);
+
+        std::vector<std::vector<double>> J;
+        int assembled = 0;
+        long long entries = 0;
+        for (int i = begin; i < end; ++i) {
+            const RBDConstraint* c = cons[i];
+            const unsigned long long stamp = c->GetStamp();
+            if (incremental && stamp == m_stamps[i])
+                continue;
+            m_stamps[i] = stamp;
+            ++assembled;
+            entries += m_jac_begin[i + 1] - m_jac_begin[i];
+            const int cols = m_dims[i] > 0 ? (m_jac_begin[i + 1] - m_jac_begin[i]) / m_dims[i] : 0;
+
+            // Jacobian 块 [dim x cols]，行主序
+            c->ComputeJacobian(J);
+            double* out = m_jac.data() + m_jac_begin[i];
+            for (int r = 0; r < m_dims[i]; ++r)
+                for (int k = 0; k < cols; ++k)
+                    *out++ = J[r][k];
+
+            m_bias[m_offsets[i]] = c->GetBiasFactor() * c->GetBiasTerm();
+            for (int r = 0; r < m_dims[i]; ++r)
+                m_compliance[m_offsets[i] + r] = c->GetCompliance();
+            if (c->GetProjectionType() == RBDProjectionType::FRICTION_CONE)
+                m_cone_mu[(m_offsets[i] - cone_begin) / 3] = c->GetFrictionCoefficient();
+        }
+
+        RBDAssemblyThreadStats stats;
+        stats.constraints = assembled;
+        stats.jacobian_entries = entries;
+        stats.seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+        return stats;
+    }
+
+    void RBDConstraintBatches::BuildTranspose() {
+        // 按变量偏移对槽做计数排序（稳定）：同一变量的槽保持约束的添加顺序
+        const int ns = static_cast<int>(m_slot_offset.size());
+        int max_offset = 0;
+        for (int s = 0; s < ns; ++s)
+            max_offset = std::max(max_offset, m_slot_offset[s]);
+        std::vector<int> bucket(ns > 0 ? max_offset + 2 : 1, 0);
+        for (int s = 0; s < ns; ++s)
+            ++bucket[m_slot_offset[s] + 1];
+        for (std::size_t k = 1; k < bucket.size(); ++k)
+            bucket[k] += bucket[k - 1];
+        m_var_slots.resize(ns);
+        for (int s = 0; s < ns; ++s)
+            m_var_slots[bucket[m_slot_offset[s]]++] = s;
+
+        m_var_offset.clear();
+        m_var_dof.clear();
+        m_var_begin.clear();
+        m_num_dofs = 0;
+        long long total = 0, heaviest = 0, load = 0;
+        for (int k = 0; k < ns; ++k) {
+            const int s = m_var_slots[k];
+            if (m_var_offset.empty() || m_var_offset.back() != m_slot_offset[s]) {
+                heaviest = std::max(heaviest, load);
+                load = 0;
+                m_var_offset.push_back(m_slot_offset[s]);
+                m_var_dof.push_back(m_slot_dof[s]);
+                m_var_begin.push_back(k);
+                m_num_dofs = std::max(m_num_dofs, m_slot_offset[s] + m_slot_dof[s]);
+            }
+            // 负载 ~ 该槽贡献的乘加次数
+            const long long work = static_cast<long long>(m_dims[m_slot_con[s]]) * m_slot_dof[s];
+            load += work;
+            total += work;
+        }
+        heaviest = std::max(heaviest, load);
+        m_var_begin.push_back(ns);
+
+        // 单个变量承担超过 1/8 的工作量时按变量并行会严重失衡，改用分块累加
+        m_active_mode = m_transpose_mode;
+        if (m_active_mode == RBDTransposeMode::AUTO)
+            m_active_mode = heaviest * 8 > total ? RBDTransposeMode::ACCUMULATE : RBDTransposeMode::GATHER;
+
+        // 分块数只取决于约束数，保证结果与线程数无关
+        const int n = static_cast<int>(m_offsets.size());
+        m_acc_blocks = std::min(16, std::max(1, n / 2048));
+    }
+
+    void RBDConstraintBatches::Project(std::vector<double>& lambda) const {
+        double* lam = lambda.data();
+
+        ProjectBatched(lam);
+
+        // CUSTOM：逐个回退到虚函数 Project()，直接在 λ 的片段上原地投影
+        for (std::size_t k = 0; k < m_custom.size(); ++k) {
+            const int off = m_custom_offsets[k];
+            const int dim = m_custom[k]->GetConstraintDim();
+            m_custom[k]->Project(RBDSpan<double>(lam + off, dim));
+        }
+    }
+
+    void RBDConstraintBatches::ProjectBatched(double* lam) const {
+        // BILATERAL：λ ∈ R，无操作
+
+        // UNILATERAL：λ ≥ 0，一段连续区间上的无分支循环
+        const int ub = GetBegin(RBDProjectionType::UNILATERAL);
+        const int ue = GetEnd(RBDProjectionType::UNILATERAL);
+        for (int i = ub; i < ue; ++i)
+            lam[i] = lam[i] < 0.0 ? 0.0 : lam[i];
+
+        // FRICTION_CONE：每个接触 3 行 [n, t1, t2]，按固定大小的包转成 SoA 后做 SIMD 锥投影。
+        // 缓冲在栈上，不修改成员，多个线程可以同时投影
+        const int nc = static_cast<int>(m_cone_mu.size());
+        const RBDVectorKernels& K = RBDGetVectorKernels();
+        double* cone = lam + GetBegin(RBDProjectionType::FRICTION_CONE);
+        double fn[kConePack], t1[kConePack], t2[kConePack];
+        for (int first = 0; first < nc; first += kConePack) {
+            const int m = std::min(kConePack, nc - first);
+            double* p = cone + 3 * first;
+            for (int k = 0; k < m; ++k) {
+                fn[k] = p[3 * k];
+                t1[k] = p[3 * k + 1];
+                t2[k] = p[3 * k + 2];
+            }
+            K.ProjectFrictionCone(m, m_cone_mu.data() + first, fn, t1, t2);
+            for (int k = 0; k < m; ++k) {
+                p[3 * k] = fn[k];
+                p[3 * k + 1] = t1[k];
+                p[3 * k + 2] = t2[k];
+            }
+        }
+    }
+
+    void RBDConstraintBatches::MultiplyTranspose(const double* lambda, double* v,
+        std::vector<double>& scratch) const {
+        RBDThreadPool& pool = RBDGetThreadPool();
+        if (m_active_mode == RBDTransposeMode::GATHER) {
+            // 每个变量只由一个线程写入，且按固定的约束顺序求和
+            const int nv = static_cast<int>(m_var_offset.size());
+            pool.ParallelFor(0, nv, 256, [&](int begin, int end) {
+                GatherRange(begin, end, lambda, v);
+            });
+            return;
+        }
+
+        const int n = static_cast<int>(m_offsets.size());
+        const int blocks = m_acc_blocks;
+        if (blocks == 1) {
+            ScatterRange(0, n, lambda, v);
+            return;
+        }
+
+        // 第 b 块约束散射到私有向量 scratch[b]，块的划分与线程数无关
+        const int nd = m_num_dofs;
+        std::vector<double>& acc = scratch;
+        acc.assign(static_cast<std::size_t>(blocks) * nd, 0.0);
+        pool.ParallelFor(0, blocks, 1, [&](int bb, int be) {
+            for (int b = bb; b < be; ++b)
+                ScatterRange(static_cast<int>(static_cast<long long>(n) * b / blocks),
+                    static_cast<int>(static_cast<long long>(n) * (b + 1) / blocks),
+                    lambda, acc.data() + static_cast<std::size_t>(b) * nd);
+        });
+
+        // 归约：按块序号依次相加
+        pool.ParallelFor(0, nd, 4096, [&](int begin, int end) {
+            for (int j = begin; j < end; ++j) {
+                double sum = acc[j];
+                for (int b = 1; b < blocks; ++b)
+                    sum += acc[static_cast<std::size_t>(b) * nd + j];
+                v[j] += sum;
+            }
+        });
+    }
+
+    void RBDConstraintBatches::GatherRange(int begin, int end, const double* lambda, double* v) const {
+        for (int k = begin; k < end; ++k) {
+            double* vs = v + m_var_offset[k];
+            const int dof = m_var_dof[k];
+            for (int e = m_var_begin[k]; e < m_var_begin[k + 1]; ++e) {
+                const int s = m_var_slots[e];
+                const int i = m_slot_con[s];
+                const int dim = m_dims[i];
+                const int cols = (m_jac_begin[i + 1] - m_jac_begin[i]) / (dim > 0 ? dim : 1);
+                const double* J = m_jac.data() + m_jac_begin[i] + m_slot_col[s];
+                for (int r = 0; r < dim; ++r) {
+                    const double l = lambda[m_offsets[i] + r];
+                    if (l == 0.0)
+                        continue;
+                    const double* row = J + r * cols;
+                    for (int d = 0; d < dof; ++d)
+                        vs[d] += row[d] * l;
+                }
+            }
+        }
+    }
+
+    void RBDConstraintBatches::ScatterRange(int begin, int end, const double* lambda, double* v) const {
+        for (int i = begin; i < end; ++i) {
+            const int dim = m_dims[i];
+            const int cols = (m_jac_begin[i + 1] - m_jac_begin[i]) / (dim > 0 ? dim : 1);
+            const double* J = m_jac.data() + m_jac_begin[i];
+            for (int r = 0; r < dim; ++r) {
+                const double l = lambda[m_offsets[i] + r];
+                if (l == 0.0)
+                    continue;
+                const double* row = J + r * cols;
+                for (int s = m_slot_begin[i]; s < m_slot_begin[i + 1]; ++s) {
+                    double* vs = v + m_slot_offset[s];
+                    for (int d = 0; d < m_slot_dof[s]; ++d)
+                        vs[d] += row[d] * l;
+                    row += m_slot_dof[s];
+                }
+            }
+        }
+    }
+
+    void RBDConstraintBatches::Multiply(const double* v, double* out) const {
+        // 各约束的输出行互不重叠，按约束并行
+        const int n = static_cast<int>(m_offsets.size());
+        RBDGetThreadPool().ParallelFor(0, n, 256, [&](int begin, int end) {
+            MultiplyRange(begin, end, v, out);
+        });
+    }
+
+    void RBDConstraintBatches::MultiplyRange(int begin, int end, const double* v, double* out) const {
+        for (int i = begin; i < end; ++i) {
+            const int dim = m_dims[i];
+            const int cols = (m_jac_begin[i + 1] - m_jac_begin[i]) / (dim > 0 ? dim : 1);
+            const double* J = m_jac.data() + m_jac_begin[i];
+            for (int r = 0; r < dim; ++r) {
+                const double* row = J + r * cols;
+                double sum = 0.0;
+                for (int s = m_slot_begin[i]; s < m_slot_begin[i + 1]; ++s) {
+                    const double* vs = v + m_slot_offset[s];
+                    for (int d = 0; d < m_slot_dof[s]; ++d)
+                        sum += row[d] * vs[d];
+                    row += m_slot_dof[s];
+                }
+                out[m_offsets[i] + r] = sum;
+            }
+        }
+    }
+
+    void RBDConstraintBatches::AddComplianceProduct(const double* lambda, double* out) const {
+        if (!m_has_compliance)
+            return;
+        RBDGetThreadPool().ParallelFor(0, m_num_rows, 4096, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i)
+                out[i] += m_compliance[i] * lambda[i];
+        });
+    }
+
+    void RBDConstraintBatches::BuildBiVector(std::vector<double>& b) const {
+        b = m_bias;
+    }
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,194 @@
+﻿// =============================================================================
+//  RBDEnsembleSchur.cpp
+//
+//  Schur complement operator over several structurally identical systems,
+//  with every vector interleaved as [row][scene] so the innermost loops run
+//  across scenes.
+// =============================================================================
+
+#include "RBDEnsembleSchur.h"
+#include "RBDVectorKernels.h"
+
+#include <cassert>
+
+namespace VSLibRBDynamX {
+
+    void RBDEnsembleSchur::SetupStructure(const RBDSystemDescriptor& sysd, int num_scenes) {
+        const int S = num_scenes;
+        m_num_scenes = S;
+        m_num_rows = sysd.CountActiveConstraints();
+        m_num_dofs = sysd.CountActiveVariables();
+        m_entry_row.clear();
+        m_entry_col.clear();
+        m_types.clear();
+        m_unilateral.clear();
+        m_cone_offsets.clear();
+        m_custom_offsets.clear();
+        m_custom_dims.clear();
+
+        // 元素按 (约束, 行, 变量, 自由度) 的顺序编号，与 ComputeJacobian 的列顺序一致
+        for (auto* c : sysd.GetConstraints()) {
+            const int offset = c->GetOffset();
+            const int dim = c->GetConstraintDim();
+            for (int r = 0; r < dim; ++r) {
+                for (auto* v : c->GetVariables()) {
+                    for (int d = 0; d < v->GetDOF(); ++d) {
+                        m_entry_row.push_back(offset + r);
+                        m_entry_col.push_back(v->GetOffset() + d);
+                    }
+                }
+            }
+
+            const RBDProjectionType type = c->GetProjectionType();
+            m_types.push_back(type);
+            switch (type) {
+            case RBDProjectionType::BILATERAL:
+                break;
+            case RBDProjectionType::UNILATERAL:
+                if (!m_unilateral.empty() && m_unilateral.back() == offset) {
+                    m_unilateral.back() = offset + dim;
+                } else {
+                    m_unilateral.push_back(offset);
+                    m_unilateral.push_back(offset + dim);
+                }
+                break;
+            case RBDProjectionType::FRICTION_CONE:
+                m_cone_offsets.push_back(offset);
+                break;
+            default:
+                m_custom_offsets.push_back(offset);
+                m_custom_dims.push_back(dim);
+                break;
+            }
+        }
+
+        // D 按行、M^{-1}D^T 按速度分量各做一次稳定的计数排序，得到两个 CSR
+        const std::size_t num_entries = m_entry_row.size();
+        auto build = [num_entries](const std::vector<int>& key, const std::vector<int>& other, int n,
+            std::vector<int>& ptr, std::vector<int>& idx, std::vector<int>& pos) {
+            ptr.assign(n + 1, 0);
+            for (int k : key)
+                ++ptr[k + 1];
+            for (int j = 0; j < n; ++j)
+                ptr[j + 1] += ptr[j];
+            std::vector<int> next(ptr.begin(), ptr.end() - 1);
+            idx.resize(num_entries);
+            pos.resize(num_entries);
+            for (std::size_t e = 0; e < num_entries; ++e) {
+                const int p = next[key[e]]++;
+                idx[p] = other[e];
+                pos[e] = p;
+            }
+        };
+        build(m_entry_row, m_entry_col, m_num_rows, m_d_ptr, m_d_col, m_d_pos);
+        build(m_entry_col, m_entry_row, m_num_dofs, m_t_ptr, m_t_row, m_t_pos);
+
+        m_jac.assign(num_entries * S, 0.0);
+        m_eq.assign(num_entries * S, 0.0);
+        m_bias.assign(static_cast<std::size_t>(m_num_rows) * S, 0.0);
+        m_compliance.clear();
+        m_cone_mu.assign(m_cone_offsets.size() * S, 0.0);
+        m_custom.assign(m_custom_offsets.size() * S, nullptr);
+    }
+
+    void RBDEnsembleSchur::SetupLane(int s, const RBDSystemDescriptor& sysd) {
+        const std::size_t S = static_cast<std::size_t>(m_num_scenes);
+        const auto& cons = sysd.GetConstraints();
+        assert(sysd.CountActiveConstraints() == m_num_rows && sysd.CountActiveVariables() == m_num_dofs &&
+            cons.size() == m_types.size() && "RBDEnsembleSchur: scenes must have identical structure");
+
+        std::size_t e = 0, cone = 0, custom = 0;
+        for (std::size_t i = 0; i < cons.size(); ++i) {
+            const RBDConstraint* c = cons[i];
+            assert(c->GetProjectionType() == m_types[i] &&
+                (e == m_entry_row.size() || c->GetOffset() == m_entry_row[e]) &&
+                "RBDEnsembleSchur: scenes must have identical structure");
+
+            // D 块与 M^{-1}D^T 块写入交错数组的第 s 列
+            c->ComputeJacobian(m_J);
+            for (int r = 0; r < c->GetConstraintDim(); ++r) {
+                int col = 0;
+                for (auto* v : c->GetVariables()) {
+                    const int dof = v->GetDOF();
+                    assert(v->GetOffset() == m_entry_col[e] && m_entry_row[e] == c->GetOffset() + r &&
+                        "RBDEnsembleSchur: scenes must have identical structure");
+                    const double* f = m_J[r].data() + col;
+                    m_mf.resize(dof);
+                    v->ComputeMassInverseTimesVector(RBDSpan<const double>(f, dof), RBDSpan<double>(m_mf));
+                    for (int d = 0; d < dof; ++d, ++e) {
+                        m_jac[m_d_pos[e] * S + s] = f[d];
+                        m_eq[m_t_pos[e] * S + s] = m_mf[d];
+                    }
+                    col += dof;
+                }
+            }
+
+            m_bias[static_cast<std::size_t>(c->GetOffset()) * S + s] = c->GetBiasFactor() * c->GetBiasTerm();
+            if (c->GetCompliance() != 0.0 || !m_compliance.empty()) {
+                m_compliance.resize(m_bias.size(), 0.0);
+                for (int r = 0; r < c->GetConstraintDim(); ++r)
+                    m_compliance[static_cast<std::size_t>(c->GetOffset() + r) * S + s] = c->GetCompliance();
+            }
+
+            switch (m_types[i]) {
+            case RBDProjectionType::BILATERAL:
+            case RBDProjectionType::UNILATERAL:
+                break;
+            case RBDProjectionType::FRICTION_CONE:
+                m_cone_mu[cone++ * S + s] = c->GetFrictionCoefficient();
+                break;
+            default:
+                m_custom[custom++ * S + s] = c;
+                break;
+            }
+        }
+    }
+
+    void RBDEnsembleSchur::SchurComplementProduct(const std::vector<double>& lambda,
+        std::vector<double>& result) const {
+        const int S = m_num_scenes;
+        const RBDVectorKernels& K = RBDGetVectorKernels();
+
+        // v = M^{-1}D^T λ，result = D v（每个输出元素在寄存器中累加，无需清零）
+        m_v.resize(static_cast<std::size_t>(m_num_dofs) * S);
+        K.LaneCsrMultiply(m_num_dofs, S, m_t_ptr.data(), m_t_row.data(), m_eq.data(), lambda.data(), m_v.data());
+        result.resize(static_cast<std::size_t>(m_num_rows) * S);
+        K.LaneCsrMultiply(m_num_rows, S, m_d_ptr.data(), m_d_col.data(), m_jac.data(), m_v.data(), result.data());
+        for (std::size_t i = 0; i < m_compliance.size(); ++i)
+            result[i] += m_compliance[i] * lambda[i];
+    }
+
+    void RBDEnsembleSchur::ConstraintsProject(std::vector<double>& lambda) const {
+        const int S = m_num_scenes;
+        double* lam = lambda.data();
+
+        for (std::size_t k = 0; k < m_unilateral.size(); k += 2) {
+            double* p = lam + static_cast<std::size_t>(m_unilateral[k]) * S;
+            const std::size_t n = static_cast<std::size_t>(m_unilateral[k + 1] - m_unilateral[k]) * S;
+            for (std::size_t i = 0; i < n; ++i)
+                p[i] = p[i] < 0.0 ? 0.0 : p[i];
+        }
+
+        // 三行 [n][场景]、[t1][场景]、[t2][场景] 正好是锥投影内核需要的 SoA
+        const RBDVectorKernels& K = RBDGetVectorKernels();
+        for (std::size_t k = 0; k < m_cone_offsets.size(); ++k) {
+            double* fn = lam + static_cast<std::size_t>(m_cone_offsets[k]) * S;
+            K.ProjectFrictionCone(S, m_cone_mu.data() + k * S, fn, fn + S, fn + 2 * S);
+        }
+
+        // CUSTOM：逐场景取出片段，回退到各自约束的虚函数投影
+        for (std::size_t k = 0; k < m_custom_offsets.size(); ++k) {
+            const int dim = m_custom_dims[k];
+            double* p = lam + static_cast<std::size_t>(m_custom_offsets[k]) * S;
+            m_scratch.resize(dim);
+            for (int s = 0; s < S; ++s) {
+                for (int j = 0; j < dim; ++j)
+                    m_scratch[j] = p[j * S + s];
+                m_custom[k * S + s]->Project(RBDSpan<double>(m_scratch));
+                for (int j = 0; j < dim; ++j)
+                    p[j * S + s] = m_scratch[j];
+            }
+        }
+    }
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,186 @@
+﻿// =============================================================================
+//  RBDMixedPrecisionSchur.cpp
+//
+//  Single-precision storage of D and M^-1 D^T with double-precision
+//  accumulation, used by the mixed-precision mode of RBDSolverAPGD.
+// =============================================================================
+
+#include "RBDMixedPrecisionSchur.h"
+
+#include <type_traits>
+
+namespace VSLibRBDynamX {
+
+    void RBDMixedPrecisionSchur::Setup(const RBDSystemDescriptor& sysd) {
+        m_topology_stamp = sysd.GetTopologyStamp();
+        m_num_rows = sysd.CountActiveConstraints();
+        m_num_dofs = sysd.CountActiveVariables();
+        m_blocks.clear();
+        m_slot_offset.clear();
+        m_slot_dof.clear();
+        m_bias.assign(m_num_rows, 0.0f);
+        m_compliance.assign(m_num_rows, 0.0f);
+        m_has_compliance = false;
+        m_unilateral.clear();
+        m_custom.clear();
+
+        // 结构：块的位置、变量槽与投影区间
+        int jac_size = 0;
+        for (auto* c : sysd.GetConstraints()) {
+            Block blk;
+            blk.offset = c->GetOffset();
+            blk.dim = c->GetConstraintDim();
+            blk.jac_begin = jac_size;
+            blk.slot_begin = static_cast<int>(m_slot_offset.size());
+            blk.cols = 0;
+            for (auto* v : c->GetVariables()) {
+                m_slot_offset.push_back(v->GetOffset());
+                m_slot_dof.push_back(v->GetDOF());
+                blk.cols += v->GetDOF();
+            }
+            blk.slot_end = static_cast<int>(m_slot_offset.size());
+            jac_size += blk.dim * blk.cols;
+            m_blocks.push_back(blk);
+
+            // 投影：单边约束合并成连续区间，其余非等式约束回退到虚函数
+            switch (c->GetProjectionType()) {
+            case RBDProjectionType::BILATERAL:
+                break;
+            case RBDProjectionType::UNILATERAL:
+                if (!m_unilateral.empty() && m_unilateral.back() == blk.offset) {
+                    m_unilateral.back() = blk.offset + blk.dim;
+                } else {
+                    m_unilateral.push_back(blk.offset);
+                    m_unilateral.push_back(blk.offset + blk.dim);
+                }
+                break;
+            default:
+                m_custom.push_back({ c, blk.offset, blk.dim });
+                break;
+            }
+        }
+
+        // 数值
+        m_jac.resize(jac_size);
+        m_eq.resize(jac_size);
+        m_block_stamps.resize(m_blocks.size());
+        const auto& cons = sysd.GetConstraints();
+        for (std::size_t i = 0; i < cons.size(); ++i)
+            AssembleBlock(cons[i], static_cast<int>(i));
+    }
+
+    void RBDMixedPrecisionSchur::Update(const RBDSystemDescriptor& sysd) {
+        if (sysd.GetTopologyStamp() != m_topology_stamp) {
+            Setup(sysd);
+            return;
+        }
+        const bool incremental = sysd.IsIncrementalUpdate();
+        const auto& cons = sysd.GetConstraints();
+        for (std::size_t i = 0; i < cons.size(); ++i)
+            if (!incremental || BlockStamp(cons[i]) > m_block_stamps[i])
+                AssembleBlock(cons[i], static_cast<int>(i));
+    }
+
+    unsigned long long RBDMixedPrecisionSchur::BlockStamp(const RBDConstraint* c) {
+        unsigned long long stamp = c->GetStamp();
+        for (auto* v : c->GetVariables())
+            stamp = v->GetStamp() > stamp ? v->GetStamp() : stamp;
+        return stamp;
+    }
+
+    void RBDMixedPrecisionSchur::AssembleBlock(const RBDConstraint* c, int i) {
+        const Block& blk = m_blocks[i];
+        m_block_stamps[i] = BlockStamp(c);
+
+        // D 块与 M^{-1}D^T 块（后者逐行、逐变量调用质量逆得到）
+        std::vector<std::vector<double>>& J = m_J;
+        std::vector<double>& mf = m_mf;
+        c->ComputeJacobian(J);
+        float* jac = m_jac.data() + blk.jac_begin;
+        float* eq = m_eq.data() + blk.jac_begin;
+        for (int r = 0; r < blk.dim; ++r) {
+            int col = 0;
+            for (auto* v : c->GetVariables()) {
+                const int dof = v->GetDOF();
+                const double* f = J[r].data() + col;
+                mf.resize(dof);
+                v->ComputeMassInverseTimesVector(RBDSpan<const double>(f, dof), RBDSpan<double>(mf));
+                for (int d = 0; d < dof; ++d) {
+                    *jac++ = static_cast<float>(f[d]);
+                    *eq++ = static_cast<float>(mf[d]);
+                }
+                col += dof;
+            }
+        }
+
+        m_bias[blk.offset] = static_cast<float>(c->GetBiasFactor() * c->GetBiasTerm());
+        const float e = static_cast<float>(c->GetCompliance());
+        for (int r = 0; r < blk.dim; ++r)
+            m_compliance[blk.offset + r] = e;
+        m_has_compliance = m_has_compliance || e != 0.0f;
+    }
+
+    void RBDMixedPrecisionSchur::SchurComplementProduct(const std::vector<float>& lambda,
+        std::vector<float>& result) const {
+        // v = M^{-1}D^T λ
+        m_v.assign(m_num_dofs, 0.0);
+        for (const auto& blk : m_blocks) {
+            const float* eq = m_eq.data() + blk.jac_begin;
+            for (int r = 0; r < blk.dim; ++r) {
+                const double l = lambda[blk.offset + r];
+                const float* row = eq + r * blk.cols;
+                if (l == 0.0)
+                    continue;
+                for (int s = blk.slot_begin; s < blk.slot_end; ++s) {
+                    double* vs = m_v.data() + m_slot_offset[s];
+                    for (int d = 0; d < m_slot_dof[s]; ++d)
+                        vs[d] += row[d] * l;
+                    row += m_slot_dof[s];
+                }
+            }
+        }
+
+        // result = D v
+        result.resize(m_num_rows);
+        for (const auto& blk : m_blocks) {
+            const float* jac = m_jac.data() + blk.jac_begin;
+            for (int r = 0; r < blk.dim; ++r) {
+                const float* row = jac + r * blk.cols;
+                double sum = 0.0;
+                for (int s = blk.slot_begin; s < blk.slot_end; ++s) {
+                    const double* vs = m_v.data() + m_slot_offset[s];
+                    for (int d = 0; d < m_slot_dof[s]; ++d)
+                        sum += row[d] * vs[d];
+                    row += m_slot_dof[s];
+                }
+                if (m_has_compliance)
+                    sum += static_cast<double>(m_compliance[blk.offset + r]) * lambda[blk.offset + r];
+                result[blk.offset + r] = static_cast<float>(sum);
+            }
+        }
+    }
+
+    template <class Real>
+    void RBDMixedPrecisionSchur::ConstraintsProject(std::vector<Real>& lambda) const {
+        Real* lam = lambda.data();
+        for (std::size_t k = 0; k < m_unilateral.size(); k += 2)
+            for (int i = m_unilateral[k]; i < m_unilateral[k + 1]; ++i)
+                lam[i] = lam[i] < Real(0) ? Real(0) : lam[i];
+
+        for (const auto& cp : m_custom) {
+            if constexpr (std::is_same<Real, double>::value) {
+                cp.con->Project(RBDSpan<double>(lam + cp.offset, cp.dim));
+            } else {
+                // float λ 需要先转换成 double 片段
+                m_scratch.assign(lam + cp.offset, lam + cp.offset + cp.dim);
+                cp.con->Project(RBDSpan<double>(m_scratch));
+                for (int j = 0; j < cp.dim; ++j)
+                    lam[cp.offset + j] = static_cast<Real>(m_scratch[j]);
+            }
+        }
+    }
+
+    template void RBDMixedPrecisionSchur::ConstraintsProject<float>(std::vector<float>&) const;
+    template void RBDMixedPrecisionSchur::ConstraintsProject<double>(std::vector<double>&) const;
+
+} // namespace VSLibRBDynamX
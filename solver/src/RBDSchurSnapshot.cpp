@@ -0,0 +1,185 @@
+﻿// =============================================================================
+//  RBDSchurSnapshot.cpp
+//
+//  Double-precision copy of D, M^-1 D^T, biases and projection data taken
+//  from a system descriptor, used by the asynchronous APGD solve.
+// =============================================================================
+
+#include "RBDSchurSnapshot.h"
+#include "RBDConstraintContact.h"
+#include "RBDThreadPool.h"
+
+#include <cassert>
+
+namespace VSLibRBDynamX {
+
+    void RBDSchurSnapshot::Setup(const RBDSystemDescriptor& sysd) {
+        m_num_rows = sysd.CountActiveConstraints();
+        m_num_dofs = sysd.CountActiveVariables();
+        m_blocks.clear();
+        m_jac.clear();
+        m_eq.clear();
+        m_slot_offset.clear();
+        m_slot_dof.clear();
+        m_bias.assign(m_num_rows, 0.0);
+        m_compliance.clear();
+        m_unilateral.clear();
+        m_cone_offsets.clear();
+        m_cone_mu.clear();
+        m_custom.clear();
+        m_vars.clear();
+        m_var_offset.clear();
+        m_var_dof.clear();
+
+        for (auto* v : sysd.GetVariables()) {
+            m_vars.push_back(v);
+            m_var_offset.push_back(v->GetOffset());
+            m_var_dof.push_back(v->GetDOF());
+        }
+
+        // 每行的投影类型，用来求出开头连续的 BILATERAL / UNILATERAL 段
+        std::vector<RBDProjectionType> row_type(m_num_rows, RBDProjectionType::BILATERAL);
+
+        std::vector<std::vector<double>> J;
+        std::vector<double> mf;
+        for (auto* c : sysd.GetConstraints()) {
+            Block blk;
+            blk.offset = c->GetOffset();
+            blk.dim = c->GetConstraintDim();
+            blk.jac_begin = static_cast<int>(m_jac.size());
+            blk.slot_begin = static_cast<int>(m_slot_offset.size());
+            blk.cols = 0;
+            for (auto* v : c->GetVariables()) {
+                m_slot_offset.push_back(v->GetOffset());
+                m_slot_dof.push_back(v->GetDOF());
+                blk.cols += v->GetDOF();
+            }
+            blk.slot_end = static_cast<int>(m_slot_offset.size());
+
+            // D 块与 M^{-1}D^T 块（后者逐行、逐变量调用质量逆得到）
+            c->ComputeJacobian(J);
+            for (int r = 0; r < blk.dim; ++r) {
+                int col = 0;
+                for (auto* v : c->GetVariables()) {
+                    const int dof = v->GetDOF();
+                    const double* f = J[r].data() + col;
+                    mf.resize(dof);
+                    v->ComputeMassInverseTimesVector(RBDSpan<const double>(f, dof), RBDSpan<double>(mf));
+                    m_jac.insert(m_jac.end(), f, f + dof);
+                    m_eq.insert(m_eq.end(), mf.begin(), mf.end());
+                    col += dof;
+                }
+            }
+            m_blocks.push_back(blk);
+
+            m_bias[blk.offset] = c->GetBiasFactor() * c->GetBiasTerm();
+            if (c->GetCompliance() != 0.0) {
+                m_compliance.resize(m_num_rows, 0.0);
+                for (int r = 0; r < blk.dim; ++r)
+                    m_compliance[blk.offset + r] = c->GetCompliance();
+            }
+
+            const RBDProjectionType type = c->GetProjectionType();
+            for (int r = 0; r < blk.dim; ++r)
+                row_type[blk.offset + r] = type;
+
+            switch (type) {
+            case RBDProjectionType::BILATERAL:
+                break;
+            case RBDProjectionType::UNILATERAL:
+                if (!m_unilateral.empty() && m_unilateral.back() == blk.offset) {
+                    m_unilateral.back() = blk.offset + blk.dim;
+                } else {
+                    m_unilateral.push_back(blk.offset);
+                    m_unilateral.push_back(blk.offset + blk.dim);
+                }
+                break;
+            case RBDProjectionType::FRICTION_CONE:
+                m_cone_offsets.push_back(blk.offset);
+                m_cone_mu.push_back(c->GetFrictionCoefficient());
+                break;
+            default:
+                m_custom.push_back({ c, blk.offset, blk.dim });
+                break;
+            }
+        }
+
+        int i = 0;
+        while (i < m_num_rows && row_type[i] == RBDProjectionType::BILATERAL)
+            ++i;
+        m_bilateral_end = i;
+        while (i < m_num_rows && row_type[i] == RBDProjectionType::UNILATERAL)
+            ++i;
+        m_unilateral_end = i;
+    }
+
+    void RBDSchurSnapshot::ComputeVelocities(const std::vector<double>& lambda) const {
+        m_v.assign(m_num_dofs, 0.0);
+        for (const auto& blk : m_blocks) {
+            const double* eq = m_eq.data() + blk.jac_begin;
+            for (int r = 0; r < blk.dim; ++r) {
+                const double l = lambda[blk.offset + r];
+                const double* row = eq + r * blk.cols;
+                if (l == 0.0)
+                    continue;
+                for (int s = blk.slot_begin; s < blk.slot_end; ++s) {
+                    double* vs = m_v.data() + m_slot_offset[s];
+                    for (int d = 0; d < m_slot_dof[s]; ++d)
+                        vs[d] += row[d] * l;
+                    row += m_slot_dof[s];
+                }
+            }
+        }
+    }
+
+    void RBDSchurSnapshot::SchurComplementProduct(const std::vector<double>& lambda,
+        std::vector<double>& result) const {
+        ComputeVelocities(lambda);
+
+        // result = D v（各约束的输出行互不重叠，按约束并行）
+        result.resize(m_num_rows);
+        const int n = static_cast<int>(m_blocks.size());
+        RBDGetThreadPool().ParallelFor(0, n, 256, [&](int begin, int end) {
+            for (int b = begin; b < end; ++b) {
+                const Block& blk = m_blocks[b];
+                const double* jac = m_jac.data() + blk.jac_begin;
+                for (int r = 0; r < blk.dim; ++r) {
+                    const double* row = jac + r * blk.cols;
+                    double sum = 0.0;
+                    for (int s = blk.slot_begin; s < blk.slot_end; ++s) {
+                        const double* vs = m_v.data() + m_slot_offset[s];
+                        for (int d = 0; d < m_slot_dof[s]; ++d)
+                            sum += row[d] * vs[d];
+                        row += m_slot_dof[s];
+                    }
+                    if (!m_compliance.empty())
+                        sum += m_compliance[blk.offset + r] * lambda[blk.offset + r];
+                    result[blk.offset + r] = sum;
+                }
+            }
+        });
+    }
+
+    void RBDSchurSnapshot::SetUnknowns(const std::vector<double>& lambda) const {
+        assert(static_cast<int>(lambda.size()) == m_num_rows && "RBDSchurSnapshot::SetUnknowns: lambda size mismatch");
+        ComputeVelocities(lambda);
+        for (std::size_t i = 0; i < m_vars.size(); ++i)
+            m_vars[i]->SetState(RBDSpan<const double>(m_v.data() + m_var_offset[i], m_var_dof[i]));
+    }
+
+    void RBDSchurSnapshot::ConstraintsProject(std::vector<double>& lambda) const {
+        double* lam = lambda.data();
+        for (std::size_t k = 0; k < m_unilateral.size(); k += 2)
+            for (int i = m_unilateral[k]; i < m_unilateral[k + 1]; ++i)
+                lam[i] = lam[i] < 0.0 ? 0.0 : lam[i];
+
+        for (std::size_t k = 0; k < m_cone_offsets.size(); ++k) {
+            double* p = lam + m_cone_offsets[k];
+            RBDProjectFrictionCone(m_cone_mu[k], p[0], p[1], p[2]);
+        }
+
+        for (const auto& cp : m_custom)
+            cp.con->Project(RBDSpan<double>(lam + cp.offset, cp.dim));
+    }
+
+} // namespace VSLibRBDynamX
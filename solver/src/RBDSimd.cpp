@@ -0,0 +1,109 @@
+﻿// =============================================================================
+//  RBDSimd.cpp
+//
+//  CPUID / XGETBV based detection of the SIMD level used by the kernels.
+// =============================================================================
+
+#include "RBDSimd.h"
+
+#include <atomic>
+
+#if RBD_SIMD_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace VSLibRBDynamX {
+
+    namespace {
+
+#if RBD_SIMD_X86
+        void Cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#if defined(_MSC_VER)
+            int r[4];
+            __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+            for (int i = 0; i < 4; ++i)
+                regs[i] = static_cast<unsigned>(r[i]);
+#else
+            __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        }
+
+        // XCR0：操作系统在上下文切换时保存了哪些寄存器状态
+        unsigned long long Xgetbv0() {
+#if defined(_MSC_VER)
+            return _xgetbv(0);
+#else
+            unsigned lo, hi;
+            __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+            return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+        }
+
+        RBDSimdLevel Detect() {
+            unsigned r[4];
+            Cpuid(0, 0, r);
+            const unsigned max_leaf = r[0];
+            if (max_leaf < 1)
+                return RBDSimdLevel::SCALAR;
+
+            Cpuid(1, 0, r);
+            const bool sse2 = (r[3] >> 26) & 1u;
+            const bool osxsave = (r[2] >> 27) & 1u;
+            const bool avx = (r[2] >> 28) & 1u;
+            const bool fma = (r[2] >> 12) & 1u;
+            if (!sse2)
+                return RBDSimdLevel::SCALAR;
+            if (!osxsave || !avx || !fma || max_leaf < 7)
+                return RBDSimdLevel::SSE2;
+
+            const unsigned long long xcr0 = Xgetbv0();
+            if ((xcr0 & 0x6) != 0x6)  // XMM + YMM
+                return RBDSimdLevel::SSE2;
+
+            Cpuid(7, 0, r);
+            const bool avx2 = (r[1] >> 5) & 1u;
+            const bool avx512f = (r[1] >> 16) & 1u;
+            if (!avx2)
+                return RBDSimdLevel::SSE2;
+            if (avx512f && (xcr0 & 0xE0) == 0xE0)  // opmask + ZMM
+                return RBDSimdLevel::AVX512;
+            return RBDSimdLevel::AVX2;
+        }
+#else
+        RBDSimdLevel Detect() { return RBDSimdLevel::SCALAR; }
+#endif
+
+        std::atomic<int> g_level_cap{ static_cast<int>(RBDSimdLevel::AVX512) };
+
+    } // namespace
+
+    RBDSimdLevel RBDDetectSimdLevel() {
+        static const RBDSimdLevel detected = Detect();
+        return detected;
+    }
+
+    RBDSimdLevel RBDGetSimdLevel() {
+        const int hw = static_cast<int>(RBDDetectSimdLevel());
+        const int cap = g_level_cap.load(std::memory_order_relaxed);
+        return static_cast<RBDSimdLevel>(cap < hw ? cap : hw);
+    }
+
+    void RBDSetSimdLevel(RBDSimdLevel level) {
+        g_level_cap.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
+    const char* RBDSimdLevelName(RBDSimdLevel level) {
+        switch (level) {
+        case RBDSimdLevel::SSE2: return "sse2";
+        case RBDSimdLevel::AVX2: return "avx2";
+        case RBDSimdLevel::AVX512: return "avx512";
+        default: return "scalar";
+        }
+    }
+
+} // namespace VSLibRBDynamX
@@ -3,130 +3,141 @@
 //
 //  Implementation of an Accelerated Projected Gradient Descent (APGD) solver
 //  for multibody dynamics constrained systems.
+//
+//  The iteration itself is a template in RBDSolverAPGD.h so that concrete,
+//  final descriptors can instantiate it with statically bound kernels; this
+//  file instantiates it for the virtual RBDSystemDescriptor interface.
 // =============================================================================
 
 #include "RBDSolverAPGD.h"
-#include <cmath>
-#include <algorithm>
+
+#include <cassert>
 
 namespace VSLibRBDynamX {
 
     RBDSolverAPGD::RBDSolverAPGD()
-        : nc(0), residual(0.0), m_iterations(0) {}
+        : m_iterations(0), residual(0.0), nc(0), m_mixed_precision(false), m_refine_iterations(20) {}
 
-    // 构建 Schur 补右端向量 r = -C * (M^{-1} f) - b
-    void RBDSolverAPGD::SchurBvectorCompute(RBDSystemDescriptor& sysd) {
-        // 获取变量和约束列表
-        auto& vars = sysd.GetVariables();
-        auto& cons = sysd.GetConstraints();
+    double RBDSolverAPGD::Solve(RBDSystemDescriptor& sysd) {
+        return SolveSpecialized<RBDSystemDescriptor>(sysd);
+    }
 
-        // 步骤1：构建全局系统矩阵 Z 和右端 d
-        std::vector<std::vector<double>> Z;
-        std::vector<double> d;
-        sysd.BuildSystemMatrix(Z, d);
+    bool RBDSolverAPGD::Setup(RBDSystemDescriptor& sysd) {
+        sysd.UpdateCountsAndOffsets();
+        m_setup_stamp = sysd.GetTopologyStamp();
+        return true;
+    }
 
-        // 步骤2：r = d  （d 已包含了 - b_i 部分）
-        r = d;
+    void RBDSolverAPGD::CopySettings(const RBDSolverAPGD& other) {
+        const double seconds_overhead = m_seconds_overhead;
+        const double seconds_per_iteration = m_seconds_per_iteration;
+        static_cast<RBDIterativeSolverVI&>(*this) = other;
+        m_budget_running = false;
+        if (seconds_per_iteration > 0.0) {
+            m_seconds_overhead = seconds_overhead;
+            m_seconds_per_iteration = seconds_per_iteration;
+        }
+        m_mixed_precision = other.m_mixed_precision;
+        m_refine_iterations = other.m_refine_iterations;
+        m_lipschitz_estimate = other.m_lipschitz_estimate;
+        m_lipschitz.SetIterations(other.m_lipschitz.GetIterations());
+        m_lipschitz.SetSafetyFactor(other.m_lipschitz.GetSafetyFactor());
+    }
 
-        // 若需要拆分 d = f + b，可以调用 BuildDiVector，但这里直接使用 d 即可
+    // -------------------------------------------------------------------------
+    // 异步求解
+    // -------------------------------------------------------------------------
+
+    /// 异步求解的共享状态：由句柄和线程池任务共同持有
+    struct RBDAsyncSolveState {
+        RBDSolverAPGD solver;            ///< 参数副本，拥有独立的工作区
+        RBDSchurSnapshot snapshot;       ///< 描述器快照（Join 也按它的布局写回）
+        std::atomic<bool> cancel{ false };
+        RBDTaskGroup group;
+    };
+
+    RBDSolveHandle RBDSolverAPGD::SolveAsync(RBDSystemDescriptor& sysd) {
+        auto state = std::make_shared<RBDAsyncSolveState>();
+        RBDSolverAPGD& s = state->solver;
+        s.CopySettings(*this);
+        s.m_cancel = &state->cancel;
+        s.m_lipschitz = m_lipschitz;  // 以本求解器保存的特征向量热启动
+
+        // 快照在调用线程上建立，此后任务不再访问变量；结构沿用记在本求解器上
+        Prepare(sysd);
+        state->snapshot.Setup(sysd);
+        if (m_mixed_precision && sysd.CountActiveConstraints() > 0)
+            s.m_mixed.Setup(sysd);
+
+        // 只交给工作线程：放进普通队列时，调用线程在其它 Wait 中可能取走整个求解
+        RBDGetThreadPool().RunOnWorker(state->group, [state]() {
+            state->solver.SolveAssembled(state->snapshot);
+        });
+
+        RBDSolveHandle handle;
+        handle.m_state = std::move(state);
+        return handle;
     }
 
-    // 计算投影梯度范数：|| (λ - proj(λ - t*(N*λ + r))) / t ||
-    double RBDSolverAPGD::Res4(const std::vector<double>& lam) const {
-        std::vector<double> Nlam(nc), tmp2(nc);
-        // Nlam = Z * lam
-        for (int i = 0; i < nc; ++i) {
-            double sum = 0;
-            for (int j = 0; j < nc; ++j) sum += /*Z[i][j]*/ 0.0 * lam[j];
-            Nlam[i] = sum;
+    RBDSolveHandle::~RBDSolveHandle() {
+        if (IsValid()) {
+            Cancel();
+            RBDGetThreadPool().Wait(m_state->group);
         }
-        // tmp2 = lam - t*(Nlam + r)
-        // 但此处 t 不在参数中，我们在 Solve 里直接计算残差，故这里仅返回 0
-        return 0.0;
     }
 
-    double RBDSolverAPGD::Solve(RBDSystemDescriptor& sysd) {
-        // 构建尺寸
-        nc = static_cast<int>(sysd.GetConstraints().size());
-        gamma.assign(nc, 0.0);
-        gammaNew.assign(nc, 0.0);
-        gamma_hat.assign(nc, 1.0);
-        y.assign(nc, 0.0);
-        yNew.assign(nc, 0.0);
-        g.assign(nc, 0.0);
-        r.assign(nc, 0.0);
-        tmp.assign(nc, 0.0);
-
-        // 构建 Schur 补右端向量
-        SchurBvectorCompute(sysd);
-
-        if (nc == 0) {
-            residual = 0.0;
-            return residual;
+    RBDSolveHandle& RBDSolveHandle::operator=(RBDSolveHandle&& other) noexcept {
+        if (this != &other) {
+            if (IsValid()) {
+                Cancel();
+                RBDGetThreadPool().Wait(m_state->group);
+            }
+            m_state = std::move(other.m_state);
+            m_joined = other.m_joined;
         }
+        return *this;
+    }
 
-        // 算法参数
-        double L = 1.0;
-        double t = 1.0;
-        double theta = 1.0;
-        double thetaNew = 1.0;
-        double Beta = 0.0;
-
-        residual = 1e30;
-
-        // 初始 guess
-        // gamma 已置零或通过 warm start 设置
-        y = gamma;
-
-        // 主循环
-        for (m_iterations = 0; m_iterations < m_max_iterations; ++m_iterations) {
-            // g = Z * y
-            // 此处省略稠密矩阵 Z，只用 r 模拟
-            for (int i = 0; i < nc; ++i) {
-                g[i] = r[i]; // 模拟 N*y
-            }
+    bool RBDSolveHandle::IsReady() const {
+        return m_state != nullptr && m_state->group.GetPending() == 0;
+    }
 
-            // 乘子更新并投影
-            for (int i = 0; i < nc; ++i) {
-                gammaNew[i] = y[i] - t * (g[i] + r[i]);
-                // 简单非负投影
-                if (gammaNew[i] < 0.0) gammaNew[i] = 0.0;
-            }
+    void RBDSolveHandle::Cancel() {
+        if (m_state)
+            m_state->cancel.store(true, std::memory_order_relaxed);
+    }
 
-            // Nesterov step
-            thetaNew = (std::sqrt(theta * theta + 4.0) - theta) / 2.0;
-            Beta = theta * (1.0 - theta) / (theta * theta + thetaNew);
-            for (int i = 0; i < nc; ++i) {
-                yNew[i] = gammaNew[i] + Beta * (gammaNew[i] - gamma[i]);
-            }
+    double RBDSolveHandle::Join() {
+        assert(IsValid() && "RBDSolveHandle::Join called on an empty or joined handle");
+        RBDGetThreadPool().Wait(m_state->group);
+        m_joined = true;
 
-            // 计算残差
-            double res = 0.0;
-            for (int i = 0; i < nc; ++i) {
-                double diff = gammaNew[i] - yNew[i];
-                res += diff * diff;
-            }
-            res = std::sqrt(res);
+        RBDSolverAPGD& s = m_state->solver;
+        if (s.nc > 0)
+            m_state->snapshot.SetUnknowns(s.m_vec.gamma_hat);
+        return s.residual;
+    }
 
-            // 更新最优解
-            if (res < residual) {
-                residual = res;
-                gamma_hat = gammaNew;
-            }
-            if (res < m_tolerance)
-                break;
-
-            // 准备下次迭代
-            gamma = gammaNew;
-            y = yNew;
-            theta = thetaNew;
-            t = 1.0 / L;
-        }
+    int RBDSolveHandle::GetIterations() const {
+        return m_state ? m_state->solver.m_iterations : 0;
+    }
+
+    bool RBDSolveHandle::WasCancelled() const {
+        return m_state != nullptr && m_state->cancel.load(std::memory_order_relaxed);
+    }
 
-        // 写回解
-        sysd.SetUnknowns(gamma_hat);
+    bool RBDSolveHandle::IsBudgetExceeded() const {
+        return m_state != nullptr && m_state->solver.IsBudgetExceeded();
+    }
+
+    const RBDLipschitzEstimator& RBDSolveHandle::GetLipschitzEstimator() const {
+        assert(m_joined && "RBDSolveHandle::GetLipschitzEstimator requires Join()");
+        return m_state->solver.m_lipschitz;
+    }
 
-        return residual;
+    const std::vector<double>& RBDSolveHandle::GetLambda() const {
+        assert(m_joined && "RBDSolveHandle::GetLambda requires Join()");
+        return m_state->solver.m_vec.gamma_hat;
     }
 
 } // namespace VSLibRBDynamX
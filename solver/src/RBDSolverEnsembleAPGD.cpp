@@ -0,0 +1,284 @@
+﻿// =============================================================================
+//  RBDSolverEnsembleAPGD.cpp
+//
+//  Lock-step APGD over packs of structurally identical systems. Vectors are
+//  interleaved as [row][scene] and every scalar of the iteration (step size,
+//  momentum, residual, best iterate) is kept per scene.
+// =============================================================================
+
+#include "RBDSolverEnsembleAPGD.h"
+#include "RBDEnsembleSchur.h"
+#include "RBDThreadPool.h"
+#include "RBDVectorKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace VSLibRBDynamX {
+
+    /// 一包：算子、交错工作区与每通道的标量
+    struct RBDSolverEnsembleAPGD::Pack {
+        RBDEnsembleSchur op;
+
+        // [行][通道] 交错的向量
+        std::vector<double> gamma, gammaNew, gamma_hat, y, yNew, g, r, tmp, res;
+
+        // 每通道一份的标量
+        std::vector<double> L, negt, theta, thetaNew, beta;  ///< negt = -1 / L
+        std::vector<double> fy, rsq, best;
+        std::vector<double> sums;     ///< 通道内核的求和结果，每通道 3 个
+        std::vector<char> active, reset;
+        std::vector<int> scene;       ///< 通道当前的场景编号（-1 表示空闲）
+        std::vector<int> iterations;  ///< 通道当前场景已迭代的轮数
+    };
+
+    RBDSolverEnsembleAPGD::RBDSolverEnsembleAPGD() = default;
+
+    RBDSolverEnsembleAPGD::~RBDSolverEnsembleAPGD() = default;
+
+    double RBDSolverEnsembleAPGD::Solve(RBDSystemDescriptor& sysd) {
+        return Solve(std::vector<RBDSystemDescriptor*>(1, &sysd));
+    }
+
+    double RBDSolverEnsembleAPGD::Solve(const std::vector<RBDSystemDescriptor*>& scenes) {
+        const int num_scenes = static_cast<int>(scenes.size());
+        m_residuals.assign(num_scenes, 0.0);
+        m_iterations.assign(num_scenes, 0);
+        m_error = 0.0;
+        m_num_rows = 0;
+        if (num_scenes == 0)
+            return m_error;
+
+        scenes[0]->UpdateCountsAndOffsets();
+        m_num_rows = scenes[0]->CountActiveConstraints();
+        m_lambda.assign(static_cast<std::size_t>(num_scenes) * m_num_rows, 0.0);
+
+        // 每个线程约 4 包，包内场景连续；包数不超过填满通道所需
+        RBDThreadPool& pool = RBDGetThreadPool();
+        const int max_packs = (num_scenes + m_lane_width - 1) / m_lane_width;
+        const int num_packs = std::min(max_packs, 4 * pool.GetNumThreads());
+        while (static_cast<int>(m_packs.size()) < num_packs)
+            m_packs.push_back(std::make_unique<Pack>());
+
+        pool.ParallelFor(0, num_packs, 1, [&](int begin, int end) {
+            for (int p = begin; p < end; ++p) {
+                const int first = static_cast<int>(static_cast<long long>(num_scenes) * p / num_packs);
+                const int last = static_cast<int>(static_cast<long long>(num_scenes) * (p + 1) / num_packs);
+                SolvePack(*m_packs[p], scenes, first, last);
+            }
+        });
+
+        for (double res : m_residuals)
+            m_error = std::max(m_error, res);
+        return m_error;
+    }
+
+    void RBDSolverEnsembleAPGD::Dump_Lambda(int s, std::vector<double>& temp) const {
+        const auto it = m_lambda.begin() + static_cast<std::ptrdiff_t>(s) * m_num_rows;
+        temp.assign(it, it + m_num_rows);
+    }
+
+    void RBDSolverEnsembleAPGD::SolvePack(Pack& pack, const std::vector<RBDSystemDescriptor*>& scenes,
+        int begin, int end) {
+        const int nc = m_num_rows;
+        if (nc == 0) {
+            for (int k = begin; k < end; ++k)
+                scenes[k]->UpdateCountsAndOffsets();
+            return;
+        }
+
+        const int S = std::min(m_lane_width, end - begin);
+        const int max_iterations = std::max(1, m_max_iterations);
+        RBDEnsembleSchur& op = pack.op;
+        op.SetupStructure(*scenes[0], S);
+
+        const std::size_t n = static_cast<std::size_t>(nc) * S;
+        auto& gamma = pack.gamma;
+        auto& gammaNew = pack.gammaNew;
+        auto& gamma_hat = pack.gamma_hat;
+        auto& y = pack.y;
+        auto& yNew = pack.yNew;
+        auto& g = pack.g;
+        auto& r = pack.r;
+        auto& tmp = pack.tmp;
+        auto& res = pack.res;
+        for (auto* v : { &gamma, &gammaNew, &gamma_hat, &y, &yNew, &g, &tmp, &res })
+            v->assign(n, 0.0);
+        for (auto* v : { &pack.L, &pack.negt, &pack.theta, &pack.thetaNew, &pack.beta, &pack.fy, &pack.rsq,
+            &pack.best })
+            v->assign(S, 0.0);
+        pack.sums.assign(3 * static_cast<std::size_t>(S), 0.0);
+        pack.active.assign(S, 0);
+        pack.reset.assign(S, 1);
+        pack.scene.assign(S, -1);
+        pack.iterations.assign(S, 0);
+
+        double* L = pack.L.data();
+        double* negt = pack.negt.data();
+        double* theta = pack.theta.data();
+        double* thetaNew = pack.thetaNew.data();
+        double* beta = pack.beta.data();
+        double* fy = pack.fy.data();
+        double* rsq = pack.rsq.data();
+        double* best = pack.best.data();
+        double* sums = pack.sums.data();
+        char* active = pack.active.data();
+        char* reset = pack.reset.data();
+        int* scene = pack.scene.data();
+        int* iterations = pack.iterations.data();
+
+        // 把下一个场景装入通道 s；没有剩余场景时通道空闲
+        int next = begin;
+        int busy = 0;
+        auto load = [&](int s) {
+            if (next < end) {
+                RBDSystemDescriptor* sysd = scenes[next];
+                if (next > 0)
+                    sysd->UpdateCountsAndOffsets();
+                op.SetupLane(s, *sysd);
+                scene[s] = next++;
+                reset[s] = 1;
+                ++busy;
+            } else {
+                scene[s] = -1;
+            }
+        };
+
+        // 新装入的通道从零开始：初始步长 L = ||N 1|| / ||1||（只对这些通道取 1）
+        auto start = [&]() {
+            op.BuildBiVector(r);
+            for (int i = 0; i < nc; ++i) {
+                const std::size_t o = static_cast<std::size_t>(i) * S;
+                for (int s = 0; s < S; ++s) {
+                    if (reset[s]) {
+                        gamma[o + s] = 0.0;
+                        gammaNew[o + s] = 0.0;
+                        gamma_hat[o + s] = 0.0;
+                        y[o + s] = 0.0;
+                    }
+                    tmp[o + s] = reset[s] ? 1.0 : 0.0;
+                }
+            }
+            op.SchurComplementProduct(tmp, yNew);
+            for (int s = 0; s < S; ++s)
+                rsq[s] = 0.0;
+            for (int i = 0; i < nc; ++i) {
+                const double* yn = yNew.data() + static_cast<std::size_t>(i) * S;
+                for (int s = 0; s < S; ++s)
+                    rsq[s] += yn[s] * yn[s];
+            }
+            for (int s = 0; s < S; ++s) {
+                if (!reset[s])
+                    continue;
+                L[s] = std::sqrt(rsq[s] / nc);
+                if (!(L[s] > 0.0))
+                    L[s] = 1.0;
+                negt[s] = -1.0 / L[s];
+                theta[s] = 1.0;
+                best[s] = 1e30;
+                iterations[s] = 0;
+                reset[s] = 0;
+            }
+        };
+
+        // 通道 s 的场景结束：拷出最优 λ 并写回
+        std::vector<double> lambda(nc);
+        auto finish = [&](int s) {
+            const int k = scene[s];
+            for (int i = 0; i < nc; ++i)
+                lambda[i] = gamma_hat[static_cast<std::size_t>(i) * S + s];
+            std::copy(lambda.begin(), lambda.end(), m_lambda.begin() + static_cast<std::ptrdiff_t>(k) * nc);
+            scenes[k]->SetUnknowns(lambda);
+            m_residuals[k] = best[s];
+            m_iterations[k] = iterations[s];
+            --busy;
+        };
+
+        for (int s = 0; s < S; ++s)
+            load(s);
+        start();
+
+        const RBDVectorKernels& K = RBDGetVectorKernels();
+        const double gdiff = 1.0 / (static_cast<double>(nc) * nc);
+        while (busy > 0) {
+            // g = N y + r，f(y) = y'(0.5 g + 0.5 r)
+            op.SchurComplementProduct(y, g);
+            K.LaneGradientObjective(nc, S, g.data(), r.data(), y.data(), fy);
+
+            for (int s = 0; s < S; ++s) {
+                thetaNew[s] = (-theta[s] * theta[s] + theta[s] * std::sqrt(theta[s] * theta[s] + 4.0)) / 2.0;
+                beta[s] = theta[s] * (1.0 - theta[s]) / (theta[s] * theta[s] + thetaNew[s]);
+                active[s] = scene[s] >= 0;
+            }
+
+            // 回溯：只有尚未满足充分下降条件的通道加倍 L。
+            // 其余通道的 t 不变，重算出的 γNew 与上一次逐位相同
+            bool backtrack = true;
+            while (backtrack) {
+                K.LaneWaxpy(nc, S, gammaNew.data(), y.data(), negt, g.data());
+                op.ConstraintsProject(gammaNew);
+                op.SchurComplementProduct(gammaNew, tmp);
+                K.LaneBacktrackTerms(nc, S, gammaNew.data(), y.data(), tmp.data(), r.data(), g.data(), sums);
+
+                backtrack = false;
+                for (int s = 0; s < S; ++s) {
+                    if (!active[s])
+                        continue;
+                    const double obj1 = sums[s];
+                    const double obj2 = fy[s] + sums[S + s] + 0.5 * L[s] * sums[2 * S + s];
+                    if (obj1 <= obj2 || sums[2 * S + s] == 0.0) {
+                        active[s] = 0;
+                    } else {
+                        L[s] = 2.0 * L[s];
+                        negt[s] = -1.0 / L[s];
+                        backtrack = true;
+                    }
+                }
+            }
+
+            // Nesterov 外推与投影梯度残差（tmp 中为 N γNew）
+            K.LaneExtrapolate(nc, S, gammaNew.data(), gamma.data(), beta, g.data(), yNew.data(), sums);
+            K.Waxpy(static_cast<int>(n), res.data(), tmp.data(), 1.0, r.data());
+            K.Waxpy(static_cast<int>(n), res.data(), gammaNew.data(), -gdiff, res.data());
+            op.ConstraintsProject(res);
+            K.LaneDistSquared(nc, S, gammaNew.data(), res.data(), rsq);
+
+            // 逐通道更新最优解；梯度与前进方向夹角为锐角时丢弃动量
+            for (int s = 0; s < S; ++s) {
+                const double r_s = std::sqrt(rsq[s]) / gdiff;
+                if (scene[s] >= 0 && r_s < best[s]) {
+                    best[s] = r_s;
+                    for (int i = 0; i < nc; ++i)
+                        gamma_hat[static_cast<std::size_t>(i) * S + s] = gammaNew[static_cast<std::size_t>(i) * S + s];
+                }
+                if (sums[S + s] > 0.0) {
+                    for (int i = 0; i < nc; ++i)
+                        yNew[static_cast<std::size_t>(i) * S + s] = gammaNew[static_cast<std::size_t>(i) * S + s];
+                    thetaNew[s] = 1.0;
+                }
+                L[s] = 0.9 * L[s];
+                negt[s] = -1.0 / L[s];
+                theta[s] = thetaNew[s];
+            }
+
+            std::swap(gamma, gammaNew);
+            std::swap(y, yNew);
+
+            // 收敛或达到上限的通道写回并换入下一个场景
+            bool loaded = false;
+            for (int s = 0; s < S; ++s) {
+                if (scene[s] < 0)
+                    continue;
+                ++iterations[s];
+                if (best[s] < m_tolerance || iterations[s] >= max_iterations) {
+                    finish(s);
+                    load(s);
+                    loaded = loaded || scene[s] >= 0;
+                }
+            }
+            if (loaded)
+                start();
+        }
+    }
+
+} // namespace VSLibRBDynamX
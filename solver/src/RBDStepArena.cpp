@@ -0,0 +1,81 @@
+﻿// =============================================================================
+//  RBDStepArena.cpp
+//
+//  Multi-lane bump allocator for objects that live for a single time step.
+// =============================================================================
+
+#include "RBDStepArena.h"
+
+#include <cassert>
+#include <cstdint>
+
+namespace VSLibRBDynamX {
+
+    RBDStepArena::RBDStepArena(std::size_t chunk_size, int num_lanes)
+        : m_chunk_size(chunk_size), m_lanes(num_lanes > 0 ? num_lanes : 1) {}
+
+    RBDStepArena::~RBDStepArena() {
+        Reset();
+    }
+
+    void RBDStepArena::SetNumLanes(int num_lanes) {
+        Reset();
+        m_lanes.resize(num_lanes > 0 ? num_lanes : 1);
+    }
+
+    void* RBDStepArena::Allocate(std::size_t bytes, std::size_t align, int lane) {
+        assert(lane >= 0 && lane < static_cast<int>(m_lanes.size()));
+        Lane& l = m_lanes[lane];
+
+        while (true) {
+            if (l.current < l.chunks.size()) {
+                Chunk& c = l.chunks[l.current];
+                std::uintptr_t base = reinterpret_cast<std::uintptr_t>(c.data.get());
+                std::uintptr_t p = (base + l.used + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1);
+                if (p + bytes <= base + c.size) {
+                    l.used = static_cast<std::size_t>(p + bytes - base);
+                    return reinterpret_cast<void*>(p);
+                }
+                // 当前块放不下：换到下一个块（可能是上一步留下的）
+                ++l.current;
+                l.used = 0;
+                continue;
+            }
+
+            // 没有可复用的块：向系统申请一个新块（超大请求单独成块）
+            std::size_t size = bytes + align > m_chunk_size ? bytes + align : m_chunk_size;
+            l.chunks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[size]), size });
+            l.current = l.chunks.size() - 1;
+            l.used = 0;
+        }
+    }
+
+    void RBDStepArena::Reset() {
+        for (auto& l : m_lanes) {
+            for (auto it = l.dtors.rbegin(); it != l.dtors.rend(); ++it)
+                it->destroy(it->obj);
+            l.dtors.clear();
+            l.current = 0;
+            l.used = 0;
+        }
+    }
+
+    std::size_t RBDStepArena::GetBytesUsed() const {
+        std::size_t total = 0;
+        for (const auto& l : m_lanes) {
+            for (std::size_t i = 0; i < l.current && i < l.chunks.size(); ++i)
+                total += l.chunks[i].size;
+            total += l.used;
+        }
+        return total;
+    }
+
+    std::size_t RBDStepArena::GetBytesReserved() const {
+        std::size_t total = 0;
+        for (const auto& l : m_lanes)
+            for (const auto& c : l.chunks)
+                total += c.size;
+        return total;
+    }
+
+} // namespace VSLibRBDynamX
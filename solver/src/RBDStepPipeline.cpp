@@ -0,0 +1,95 @@
+﻿// =============================================================================
+//  RBDStepPipeline.cpp
+//
+//  Three-stage (assemble / solve / write-back) pipeline over independent
+//  islands, expressed as a task graph on the global thread pool.
+// =============================================================================
+
+#include "RBDStepPipeline.h"
+
+#include <chrono>
+
+namespace VSLibRBDynamX {
+
+    namespace {
+
+        using Clock = std::chrono::steady_clock;
+
+        double SecondsSince(Clock::time_point t0) {
+            return std::chrono::duration<double>(Clock::now() - t0).count();
+        }
+
+    } // namespace
+
+    int RBDStepPipeline::AddIsland(RBDSystemDescriptor* sysd, Callback prepare, Callback finish) {
+        auto island = std::make_unique<Island>();
+        island->sysd = sysd;
+        island->prepare = std::move(prepare);
+        island->finish = std::move(finish);
+        m_islands.push_back(std::move(island));
+        return static_cast<int>(m_islands.size()) - 1;
+    }
+
+    void RBDStepPipeline::ClearIslands() {
+        m_islands.clear();
+    }
+
+    void RBDStepPipeline::Step() {
+        const Clock::time_point t0 = Clock::now();
+
+        // 任务图：每个岛 3 个任务，编号 3k + {0: 装配, 1: 求解, 2: 写回}
+        m_graph.Clear();
+        const int n = GetNumIslands();
+        for (int k = 0; k < n; ++k) {
+            Island* island = m_islands[k].get();
+            island->solver.CopySettings(m_settings);
+            m_graph.AddTask([this, island]() { Assemble(*island); });
+            m_graph.AddTask([this, island]() { SolveIsland(*island); });
+            m_graph.AddTask([this, island]() { WriteBack(*island); });
+            m_graph.AddDependency(3 * k, 3 * k + 1);
+            m_graph.AddDependency(3 * k + 1, 3 * k + 2);
+            if (k > 0) {
+                // 同一级按岛的顺序执行
+                for (int stage = 0; stage < 3; ++stage)
+                    m_graph.AddDependency(3 * (k - 1) + stage, 3 * k + stage);
+            }
+        }
+        m_graph.Run(RBDGetThreadPool());
+
+        m_step_seconds = SecondsSince(t0);
+    }
+
+    void RBDStepPipeline::Assemble(Island& island) {
+        const Clock::time_point t0 = Clock::now();
+        if (island.prepare)
+            island.prepare();
+        // 与 SolveSpecialized 一样，时间预算从求解器的装配开始计
+        const Clock::time_point t1 = Clock::now();
+        island.solver.Prepare(*island.sysd);
+        if (island.solver.m_mixed_precision && island.sysd->CountActiveConstraints() > 0)
+            island.solver.m_mixed.Update(*island.sysd);
+        island.budget_assembly = SecondsSince(t1);
+        island.stats.assemble_seconds = SecondsSince(t0);
+    }
+
+    void RBDStepPipeline::SolveIsland(Island& island) {
+        const Clock::time_point t0 = Clock::now();
+        // 装配与求解之间等待前一个岛的时间不计入预算
+        island.solver.BeginBudget(island.budget_assembly);
+        island.solver.SolveAssembled(*island.sysd);
+        island.stats.residual = island.solver.residual;
+        island.stats.iterations = island.solver.m_iterations;
+        island.stats.budget_exceeded = island.solver.IsBudgetExceeded();
+        island.stats.solve_seconds = SecondsSince(t0);
+    }
+
+    void RBDStepPipeline::WriteBack(Island& island) {
+        const Clock::time_point t0 = Clock::now();
+        if (island.solver.nc > 0)
+            island.sysd->SetUnknowns(island.solver.m_vec.gamma_hat);
+        if (island.finish)
+            island.finish();
+        island.stats.writeback_seconds = SecondsSince(t0);
+    }
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,304 @@
+﻿// =============================================================================
+//  RBDThreadPool.cpp
+//
+//  Work-stealing thread pool: per-thread deques, stealing from the front of
+//  other queues, helping waits and optional CPU pinning; plus a small
+//  dependency-counted task graph executed on top of the pool.
+// =============================================================================
+
+#include "RBDThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace VSLibRBDynamX {
+
+    namespace {
+
+        // 当前线程所属的线程池及其编号（外部线程为 nullptr / 0）
+        thread_local const RBDThreadPool* t_pool = nullptr;
+        thread_local int t_index = 0;
+
+        void PinCurrentThread(int cpu) {
+#if defined(_WIN32)
+            const int bits = static_cast<int>(sizeof(DWORD_PTR) * 8);
+            SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << (cpu % bits));
+#elif defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu % CPU_SETSIZE, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+            (void)cpu;
+#endif
+        }
+
+    } // namespace
+
+    RBDThreadPool::RBDThreadPool(int num_threads)
+        : m_queued(0), m_next(0), m_stop(false), m_pin(false) {
+        Start(num_threads);
+    }
+
+    RBDThreadPool::~RBDThreadPool() {
+        Stop();
+    }
+
+    void RBDThreadPool::SetNumThreads(int num_threads) {
+        Stop();
+        Start(num_threads);
+    }
+
+    void RBDThreadPool::SetPinning(bool pin) {
+        if (pin == m_pin)
+            return;
+        const int n = GetNumThreads();
+        Stop();
+        m_pin = pin;
+        Start(n);
+    }
+
+    void RBDThreadPool::Start(int num_threads) {
+        if (num_threads <= 0)
+            num_threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (num_threads <= 0)
+            num_threads = 1;
+
+        m_stop = false;
+        m_queues.clear();
+        for (int i = 0; i < num_threads; ++i)
+            m_queues.push_back(std::make_unique<Queue>());
+        for (int i = 1; i < num_threads; ++i)
+            m_workers.emplace_back(&RBDThreadPool::WorkerLoop, this, i);
+    }
+
+    void RBDThreadPool::Stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+            m_stop = true;
+        }
+        m_sleep_cv.notify_all();
+        for (auto& t : m_workers)
+            t.join();
+        m_workers.clear();
+        assert(m_queued.load() == 0 && "RBDThreadPool stopped with queued tasks");
+    }
+
+    int RBDThreadPool::GetThreadIndex() const {
+        return t_pool == this ? t_index : 0;
+    }
+
+    void RBDThreadPool::Run(RBDTaskGroup& group, std::function<void()> task) {
+        group.m_pending.fetch_add(1, std::memory_order_relaxed);
+
+        // 单线程：立即执行
+        if (m_workers.empty()) {
+            Task t{ std::move(task), &group };
+            Execute(t);
+            return;
+        }
+
+        // 工作线程提交到自己的队列（局部性最好），外部线程轮转分配
+        int q = GetThreadIndex();
+        if (q == 0)
+            q = static_cast<int>(m_next.fetch_add(1, std::memory_order_relaxed) % m_queues.size());
+        {
+            std::lock_guard<std::mutex> lock(m_queues[q]->mutex);
+            m_queues[q]->tasks.push_back({ std::move(task), &group });
+        }
+        m_queued.fetch_add(1, std::memory_order_release);
+        {
+            // 与 WorkerLoop 中的判断同步，避免丢失唤醒
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        }
+        m_sleep_cv.notify_one();
+    }
+
+    void RBDThreadPool::RunOnWorker(RBDTaskGroup& group, std::function<void()> task) {
+        if (m_workers.empty()) {
+            Run(group, std::move(task));
+            return;
+        }
+
+        group.m_pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(m_worker_queue.mutex);
+            m_worker_queue.tasks.push_back({ std::move(task), &group });
+        }
+        m_queued.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        }
+        m_sleep_cv.notify_one();
+    }
+
+    void RBDThreadPool::Wait(RBDTaskGroup& group) {
+        // 只帮忙执行本组的任务：取走别的组（或 RunOnWorker 的长任务）会把它整个嵌套在
+        // 当前栈上执行，本组的完成时间就包含了它
+        const int index = GetThreadIndex();
+        while (group.GetPending() > 0) {
+            if (!TryRunOne(index, &group))
+                std::this_thread::yield();
+        }
+    }
+
+    void RBDThreadPool::WorkerLoop(int index) {
+        t_pool = this;
+        t_index = index;
+        if (m_pin)
+            PinCurrentThread(index);
+
+        while (true) {
+            if (TryRunOne(index, nullptr))
+                continue;
+            std::unique_lock<std::mutex> lock(m_sleep_mutex);
+            m_sleep_cv.wait(lock, [this] { return m_stop.load() || m_queued.load(std::memory_order_acquire) > 0; });
+            if (m_stop && m_queued.load() == 0)
+                return;
+        }
+    }
+
+    bool RBDThreadPool::TryRunOne(int index, const RBDTaskGroup* group) {
+        // 空闲的工作线程（group 为空）什么都可以取，包括只给工作线程的任务
+        Task task;
+        if (Pop(index, group, task) || Steal(index, group, task) || (group == nullptr && PopWorkerOnly(task))) {
+            Execute(task);
+            return true;
+        }
+        return false;
+    }
+
+    bool RBDThreadPool::Take(Queue& q, bool back, const RBDTaskGroup* group, Task& task) {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty())
+            return false;
+        auto it = q.tasks.end();
+        if (group == nullptr) {
+            it = back ? q.tasks.end() - 1 : q.tasks.begin();
+        } else if (back) {
+            for (auto r = q.tasks.rbegin(); r != q.tasks.rend(); ++r)
+                if (r->group == group) {
+                    it = std::prev(r.base());
+                    break;
+                }
+        } else {
+            it = std::find_if(q.tasks.begin(), q.tasks.end(), [group](const Task& t) { return t.group == group; });
+        }
+        if (it == q.tasks.end())
+            return false;
+        task = std::move(*it);
+        q.tasks.erase(it);
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool RBDThreadPool::Pop(int index, const RBDTaskGroup* group, Task& task) {
+        return Take(*m_queues[index], true, group, task);
+    }
+
+    bool RBDThreadPool::Steal(int thief, const RBDTaskGroup* group, Task& task) {
+        const int n = static_cast<int>(m_queues.size());
+        for (int k = 1; k < n; ++k)
+            if (Take(*m_queues[(thief + k) % n], false, group, task))
+                return true;
+        return false;
+    }
+
+    bool RBDThreadPool::PopWorkerOnly(Task& task) {
+        std::lock_guard<std::mutex> lock(m_worker_queue.mutex);
+        if (m_worker_queue.tasks.empty())
+            return false;
+        task = std::move(m_worker_queue.tasks.front());
+        m_worker_queue.tasks.pop_front();
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void RBDThreadPool::Execute(Task& task) {
+        task.fn();
+        task.group->m_pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    RBDThreadPool& RBDGetThreadPool() {
+        static RBDThreadPool pool;
+        return pool;
+    }
+
+    // -------------------------------------------------------------------------
+    // RBDTaskGraph
+    // -------------------------------------------------------------------------
+
+    int RBDTaskGraph::AddTask(std::function<void()> fn) {
+        m_nodes.push_back(Node());
+        m_nodes.back().fn = std::move(fn);
+        return static_cast<int>(m_nodes.size()) - 1;
+    }
+
+    void RBDTaskGraph::AddDependency(int before, int after) {
+        assert(before != after && "RBDTaskGraph: self dependency");
+        m_nodes[before].successors.push_back(after);
+        ++m_nodes[after].num_deps;
+    }
+
+    void RBDTaskGraph::Clear() {
+        m_nodes.clear();
+    }
+
+    void RBDTaskGraph::Run(RBDThreadPool& pool) {
+        const int n = GetNumTasks();
+        if (n == 0)
+            return;
+
+        // 单线程：Kahn 拓扑排序后串行执行（避免 Run 立即执行导致的深递归）
+        if (pool.GetNumThreads() <= 1) {
+            std::vector<int> deps(n), ready;
+            for (int i = 0; i < n; ++i) {
+                deps[i] = m_nodes[i].num_deps;
+                if (deps[i] == 0)
+                    ready.push_back(i);
+            }
+            for (std::size_t k = 0; k < ready.size(); ++k) {
+                const Node& node = m_nodes[ready[k]];
+                node.fn();
+                for (int s : node.successors)
+                    if (--deps[s] == 0)
+                        ready.push_back(s);
+            }
+            assert(static_cast<int>(ready.size()) == n && "RBDTaskGraph: dependency cycle");
+            return;
+        }
+
+        m_remaining.reset(new std::atomic<int>[n]);
+        for (int i = 0; i < n; ++i)
+            m_remaining[i].store(m_nodes[i].num_deps, std::memory_order_relaxed);
+
+        RBDTaskGroup group;
+        for (int i = 0; i < n; ++i)
+            if (m_nodes[i].num_deps == 0)
+                Submit(pool, group, i);
+        pool.Wait(group);
+    }
+
+    void RBDTaskGraph::Submit(RBDThreadPool& pool, RBDTaskGroup& group, int index) {
+        pool.Run(group, [this, &pool, &group, index]() {
+            const Node& node = m_nodes[index];
+            node.fn();
+            // 后继在本任务计数归零之前提交，Wait 不会提前返回
+            for (int s : node.successors)
+                if (m_remaining[s].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    Submit(pool, group, s);
+        });
+    }
+
+} // namespace VSLibRBDynamX
@@ -0,0 +1,169 @@
+﻿// =============================================================================
+//  RBDVectorKernels.cpp
+//
+//  Instantiates the kernel bodies of RBDVectorKernels.inl for scalar, SSE2,
+//  AVX2 and AVX-512 and selects a table at run time.
+// =============================================================================
+
+#include "RBDVectorKernels.h"
+#include "RBDConstraintContact.h"
+
+#include <cmath>
+
+#if RBD_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace VSLibRBDynamX {
+
+    namespace {
+
+        // ---- scalar ----
+        namespace Scalar {
+            using V = double;
+            constexpr int W = 1;
+            inline V Zero() { return 0.0; }
+            inline V Set1(double a) { return a; }
+            inline V Load(const double* p) { return *p; }
+            inline void Store(double* p, V a) { *p = a; }
+            inline V Add(V a, V b) { return a + b; }
+            inline V Sub(V a, V b) { return a - b; }
+            inline V Mul(V a, V b) { return a * b; }
+            inline V Fmadd(V a, V b, V c) { return a * b + c; }
+            inline V Max(V a, V b) { return a > b ? a : b; }
+            inline V Sqrt(V a) { return std::sqrt(a); }
+            inline V Div(V a, V b) { return a / b; }
+            using M = bool;
+            inline M CmpLe(V a, V b) { return a <= b; }
+            inline M MaskAnd(M a, M b) { return a && b; }
+            inline V Select(M m, V a, V b) { return m ? a : b; }
+            inline double HSum(V a) { return a; }
+
+#define RBD_KERNEL_TARGET
+#include "RBDVectorKernels.inl"
+#undef RBD_KERNEL_TARGET
+        } // namespace Scalar
+
+#if RBD_SIMD_X86
+        // ---- SSE2 ----
+        namespace Sse2 {
+            using V = __m128d;
+            constexpr int W = 2;
+            RBD_TARGET_SSE2 inline V Zero() { return _mm_setzero_pd(); }
+            RBD_TARGET_SSE2 inline V Set1(double a) { return _mm_set1_pd(a); }
+            RBD_TARGET_SSE2 inline V Load(const double* p) { return _mm_loadu_pd(p); }
+            RBD_TARGET_SSE2 inline void Store(double* p, V a) { _mm_storeu_pd(p, a); }
+            RBD_TARGET_SSE2 inline V Add(V a, V b) { return _mm_add_pd(a, b); }
+            RBD_TARGET_SSE2 inline V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+            RBD_TARGET_SSE2 inline V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+            RBD_TARGET_SSE2 inline V Fmadd(V a, V b, V c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+            RBD_TARGET_SSE2 inline V Max(V a, V b) { return _mm_max_pd(a, b); }
+            RBD_TARGET_SSE2 inline V Sqrt(V a) { return _mm_sqrt_pd(a); }
+            RBD_TARGET_SSE2 inline V Div(V a, V b) { return _mm_div_pd(a, b); }
+            using M = __m128d;
+            RBD_TARGET_SSE2 inline M CmpLe(V a, V b) { return _mm_cmple_pd(a, b); }
+            RBD_TARGET_SSE2 inline M MaskAnd(M a, M b) { return _mm_and_pd(a, b); }
+            RBD_TARGET_SSE2 inline V Select(M m, V a, V b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+            RBD_TARGET_SSE2 inline double HSum(V a) {
+                return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)));
+            }
+
+#define RBD_KERNEL_TARGET RBD_TARGET_SSE2
+#include "RBDVectorKernels.inl"
+#undef RBD_KERNEL_TARGET
+        } // namespace Sse2
+
+        // ---- AVX2 + FMA ----
+        namespace Avx2 {
+            using V = __m256d;
+            constexpr int W = 4;
+            RBD_TARGET_AVX2 inline V Zero() { return _mm256_setzero_pd(); }
+            RBD_TARGET_AVX2 inline V Set1(double a) { return _mm256_set1_pd(a); }
+            RBD_TARGET_AVX2 inline V Load(const double* p) { return _mm256_loadu_pd(p); }
+            RBD_TARGET_AVX2 inline void Store(double* p, V a) { _mm256_storeu_pd(p, a); }
+            RBD_TARGET_AVX2 inline V Add(V a, V b) { return _mm256_add_pd(a, b); }
+            RBD_TARGET_AVX2 inline V Sub(V a, V b) { return _mm256_sub_pd(a, b); }
+            RBD_TARGET_AVX2 inline V Mul(V a, V b) { return _mm256_mul_pd(a, b); }
+            RBD_TARGET_AVX2 inline V Fmadd(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+            RBD_TARGET_AVX2 inline V Max(V a, V b) { return _mm256_max_pd(a, b); }
+            RBD_TARGET_AVX2 inline V Sqrt(V a) { return _mm256_sqrt_pd(a); }
+            RBD_TARGET_AVX2 inline V Div(V a, V b) { return _mm256_div_pd(a, b); }
+            using M = __m256d;
+            RBD_TARGET_AVX2 inline M CmpLe(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+            RBD_TARGET_AVX2 inline M MaskAnd(M a, M b) { return _mm256_and_pd(a, b); }
+            RBD_TARGET_AVX2 inline V Select(M m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+            RBD_TARGET_AVX2 inline double HSum(V a) {
+                const __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+                return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+            }
+
+#define RBD_KERNEL_TARGET RBD_TARGET_AVX2
+#include "RBDVectorKernels.inl"
+#undef RBD_KERNEL_TARGET
+        } // namespace Avx2
+
+        // ---- AVX-512F ----
+        namespace Avx512 {
+            using V = __m512d;
+            constexpr int W = 8;
+            RBD_TARGET_AVX512 inline V Zero() { return _mm512_setzero_pd(); }
+            RBD_TARGET_AVX512 inline V Set1(double a) { return _mm512_set1_pd(a); }
+            RBD_TARGET_AVX512 inline V Load(const double* p) { return _mm512_loadu_pd(p); }
+            RBD_TARGET_AVX512 inline void Store(double* p, V a) { _mm512_storeu_pd(p, a); }
+            RBD_TARGET_AVX512 inline V Add(V a, V b) { return _mm512_add_pd(a, b); }
+            RBD_TARGET_AVX512 inline V Sub(V a, V b) { return _mm512_sub_pd(a, b); }
+            RBD_TARGET_AVX512 inline V Mul(V a, V b) { return _mm512_mul_pd(a, b); }
+            RBD_TARGET_AVX512 inline V Fmadd(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+            // GCC 12 的 _mm512_max_pd / _mm512_sqrt_pd / _mm512_extractf64x4_pd（含 _mm512_reduce_add_pd 与
+            // _mm512_castpd512_pd256）以未初始化的向量作合并源，-O1 起报 -W(maybe-)uninitialized；
+            // 改用全 1 掩码的 maskz 形式（源为零向量），掩码全 1 时生成的仍是不带掩码的指令
+            RBD_TARGET_AVX512 inline V Max(V a, V b) { return _mm512_maskz_max_pd(0xFF, a, b); }
+            RBD_TARGET_AVX512 inline V Sqrt(V a) { return _mm512_maskz_sqrt_pd(0xFF, a); }
+            RBD_TARGET_AVX512 inline V Div(V a, V b) { return _mm512_div_pd(a, b); }
+            using M = __mmask8;
+            RBD_TARGET_AVX512 inline M CmpLe(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+            RBD_TARGET_AVX512 inline M MaskAnd(M a, M b) { return static_cast<M>(a & b); }
+            RBD_TARGET_AVX512 inline V Select(M m, V a, V b) { return _mm512_mask_blend_pd(m, b, a); }
+            // 与 _mm512_reduce_add_pd 相同的求和顺序：高低 256 位相加、高低 128 位相加、两个分量相加
+            RBD_TARGET_AVX512 inline double HSum(V a) {
+                const __m256d h = _mm256_add_pd(_mm512_maskz_extractf64x4_pd(0xF, a, 1), _mm512_maskz_extractf64x4_pd(0xF, a, 0));
+                const __m128d s = _mm_add_pd(_mm256_extractf128_pd(h, 1), _mm256_castpd256_pd128(h));
+                return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+            }
+
+#define RBD_KERNEL_TARGET RBD_TARGET_AVX512
+#include "RBDVectorKernels.inl"
+#undef RBD_KERNEL_TARGET
+        } // namespace Avx512
+#endif
+
+#define RBD_KERNEL_TABLE(level, ns) \
+        { level, &ns::Dot, &ns::Norm, &ns::DistSquared, &ns::Axpy, &ns::Waxpy, \
+          &ns::GradientObjective, \
+          &ns::ProjectedWaxpy, &ns::FusedUpdate, &ns::ProjectFrictionCone, \
+          &ns::LaneCsrMultiply, &ns::LaneWaxpy, &ns::LaneGradientObjective, &ns::LaneBacktrackTerms, \
+          &ns::LaneExtrapolate, &ns::LaneDistSquared }
+
+        const RBDVectorKernels g_tables[] = {
+            RBD_KERNEL_TABLE(RBDSimdLevel::SCALAR, Scalar),
+#if RBD_SIMD_X86
+            RBD_KERNEL_TABLE(RBDSimdLevel::SSE2, Sse2),
+            RBD_KERNEL_TABLE(RBDSimdLevel::AVX2, Avx2),
+            RBD_KERNEL_TABLE(RBDSimdLevel::AVX512, Avx512),
+#endif
+        };
+
+#undef RBD_KERNEL_TABLE
+
+    } // namespace
+
+    const RBDVectorKernels& RBDGetVectorKernels(RBDSimdLevel level) {
+        int l = static_cast<int>(level);
+        const int hw = static_cast<int>(RBDDetectSimdLevel());
+        if (l > hw)
+            l = hw;
+        const int last = static_cast<int>(sizeof(g_tables) / sizeof(g_tables[0])) - 1;
+        return g_tables[l < last ? l : last];
+    }
+
+} // namespace VSLibRBDynamX
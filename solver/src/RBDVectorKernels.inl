@@ -0,0 +1,354 @@
+// =============================================================================
+//  RBDVectorKernels.inl
+//
+//  Level-independent kernel bodies. Included once per instruction set by
+//  RBDVectorKernels.cpp inside a namespace that provides:
+//    V, W                          -- register type and number of doubles
+//    Zero, Set1, Load, Store       -- load/store helpers
+//    Add, Sub, Mul, Div, Fmadd,    -- arithmetic (Fmadd(a, b, c) = a*b + c)
+//    Max, Sqrt, HSum
+//    M, CmpLe, MaskAnd, Select     -- lane masks and masked blends (Select(m, a, b) = m ? a : b)
+//  and with RBD_KERNEL_TARGET defined to the matching target attribute.
+//  No include guard: intentionally included several times.
+// =============================================================================
+
+RBD_KERNEL_TARGET
+double Dot(int n, const double* x, const double* y) {
+    V acc = Zero();
+    int i = 0;
+    for (; i + W <= n; i += W)
+        acc = Fmadd(Load(x + i), Load(y + i), acc);
+    double s = HSum(acc);
+    for (; i < n; ++i)
+        s += x[i] * y[i];
+    return s;
+}
+
+RBD_KERNEL_TARGET
+double Norm(int n, const double* x) {
+    return std::sqrt(Dot(n, x, x));
+}
+
+RBD_KERNEL_TARGET
+double DistSquared(int n, const double* x, const double* y) {
+    V acc = Zero();
+    int i = 0;
+    for (; i + W <= n; i += W) {
+        const V d = Sub(Load(x + i), Load(y + i));
+        acc = Fmadd(d, d, acc);
+    }
+    double s = HSum(acc);
+    for (; i < n; ++i) {
+        const double d = x[i] - y[i];
+        s += d * d;
+    }
+    return s;
+}
+
+RBD_KERNEL_TARGET
+void Axpy(int n, double a, const double* x, double* y) {
+    const V va = Set1(a);
+    int i = 0;
+    for (; i + W <= n; i += W)
+        Store(y + i, Fmadd(va, Load(x + i), Load(y + i)));
+    for (; i < n; ++i)
+        y[i] += a * x[i];
+}
+
+RBD_KERNEL_TARGET
+void Waxpy(int n, double* w, const double* x, double a, const double* y) {
+    const V va = Set1(a);
+    int i = 0;
+    for (; i + W <= n; i += W)
+        Store(w + i, Fmadd(va, Load(y + i), Load(x + i)));
+    for (; i < n; ++i)
+        w[i] = x[i] + a * y[i];
+}
+
+RBD_KERNEL_TARGET
+double GradientObjective(int n, double* g, const double* r, const double* y) {
+    V acc = Zero();
+    int i = 0;
+    for (; i + W <= n; i += W) {
+        const V vr = Load(r + i);
+        const V vg = Add(Load(g + i), vr);
+        Store(g + i, vg);
+        acc = Fmadd(Load(y + i), Add(vg, vr), acc);
+    }
+    double s = HSum(acc);
+    for (; i < n; ++i) {
+        g[i] += r[i];
+        s += y[i] * (g[i] + r[i]);
+    }
+    return 0.5 * s;
+}
+
+RBD_KERNEL_TARGET
+void ProjectedWaxpy(int n, bool clamp, double* w, const double* x, double a, const double* y) {
+    if (!clamp) {
+        Waxpy(n, w, x, a, y);
+        return;
+    }
+    const V va = Set1(a);
+    const V zero = Zero();
+    int i = 0;
+    for (; i + W <= n; i += W)
+        Store(w + i, Max(Fmadd(va, Load(y + i), Load(x + i)), zero));
+    for (; i < n; ++i) {
+        const double v = x[i] + a * y[i];
+        w[i] = v < 0.0 ? 0.0 : v;
+    }
+}
+
+// Mode: 0 = no projection, 1 = clamp to >= 0, 2 = store the residual point for the caller
+template <int Mode>
+RBD_KERNEL_TARGET
+void FusedUpdateImpl(int n, const double* x, const double* x_old, const double* y,
+    const double* Nx, const double* r, const double* g, double beta, double gdiff,
+    double* y_new, double* res_point, double out[6]) {
+    const V half = Set1(0.5), vb = Set1(beta), vgd = Set1(-gdiff), zero = Zero();
+    V a0 = Zero(), a1 = Zero(), a2 = Zero(), a3 = Zero(), a4 = Zero(), a5 = Zero();
+    int i = 0;
+    for (; i + W <= n; i += W) {
+        const V vx = Load(x + i), vg = Load(g + i), vn = Load(Nx + i), vr = Load(r + i);
+        const V nr = Add(vn, vr);
+
+        // backtracking terms, d = x - y
+        const V d = Sub(vx, Load(y + i));
+        a0 = Fmadd(vx, Fmadd(half, vn, vr), a0);
+        a1 = Fmadd(vg, d, a1);
+        a2 = Fmadd(d, d, a2);
+
+        // extrapolation, e = x - x_old
+        const V e = Sub(vx, Load(x_old + i));
+        Store(y_new + i, Fmadd(vb, e, vx));
+        a3 = Fmadd(e, e, a3);
+        a4 = Fmadd(vg, e, a4);
+
+        // residual point p = x - gdiff (Nx + r)
+        V p = Fmadd(vgd, nr, vx);
+        if (Mode == 2) {
+            Store(res_point + i, p);
+        } else {
+            if (Mode == 1)
+                p = Max(p, zero);
+            const V q = Sub(vx, p);
+            a5 = Fmadd(q, q, a5);
+        }
+    }
+    double s0 = HSum(a0), s1 = HSum(a1), s2 = HSum(a2), s3 = HSum(a3), s4 = HSum(a4), s5 = HSum(a5);
+    for (; i < n; ++i) {
+        const double nr = Nx[i] + r[i];
+        const double d = x[i] - y[i];
+        s0 += x[i] * (0.5 * Nx[i] + r[i]);
+        s1 += g[i] * d;
+        s2 += d * d;
+        const double e = x[i] - x_old[i];
+        y_new[i] = x[i] + beta * e;
+        s3 += e * e;
+        s4 += g[i] * e;
+        double p = x[i] - gdiff * nr;
+        if (Mode == 2) {
+            res_point[i] = p;
+        } else {
+            if (Mode == 1)
+                p = p < 0.0 ? 0.0 : p;
+            s5 += (x[i] - p) * (x[i] - p);
+        }
+    }
+    out[0] = s0;
+    out[1] = s1;
+    out[2] = s2;
+    out[3] = s3;
+    out[4] = s4;
+    out[5] = s5;
+}
+
+RBD_KERNEL_TARGET
+void FusedUpdate(int n, int mode, const double* x, const double* x_old, const double* y,
+    const double* Nx, const double* r, const double* g, double beta, double gdiff,
+    double* y_new, double* res_point, double out[6]) {
+    switch (mode) {
+    case 0: FusedUpdateImpl<0>(n, x, x_old, y, Nx, r, g, beta, gdiff, y_new, res_point, out); break;
+    case 1: FusedUpdateImpl<1>(n, x, x_old, y, Nx, r, g, beta, gdiff, y_new, res_point, out); break;
+    default: FusedUpdateImpl<2>(n, x, x_old, y, Nx, r, g, beta, gdiff, y_new, res_point, out); break;
+    }
+}
+
+RBD_KERNEL_TARGET
+void ProjectFrictionCone(int n, const double* mu, double* fn, double* t1, double* t2) {
+    const V zero = Zero(), one = Set1(1.0), tiny = Set1(1e-300);
+    int i = 0;
+    for (; i + W <= n; i += W) {
+        const V m = Load(mu + i), vn = Load(fn + i), v1 = Load(t1 + i), v2 = Load(t2 + i);
+        const V ft = Sqrt(Fmadd(v1, v1, Mul(v2, v2)));
+
+        const M inside = MaskAnd(CmpLe(ft, Mul(m, vn)), CmpLe(zero, vn));
+        const M polar = CmpLe(Mul(m, ft), Sub(zero, vn));
+
+        // projection onto the cone surface; lanes with ft == 0 are always inside or polar
+        V n_new = Div(Fmadd(m, ft, vn), Fmadd(m, m, one));
+        V scale = Div(Mul(m, n_new), Max(ft, tiny));
+        n_new = Select(polar, zero, n_new);
+        scale = Select(polar, zero, scale);
+        n_new = Select(inside, vn, n_new);
+        scale = Select(inside, one, scale);
+
+        Store(fn + i, n_new);
+        Store(t1 + i, Mul(v1, scale));
+        Store(t2 + i, Mul(v2, scale));
+    }
+    for (; i < n; ++i)
+        RBDProjectFrictionCone(mu[i], fn[i], t1[i], t2[i]);
+}
+
+// ---- lane kernels: rows x lanes interleaved, per-lane scalars, per-lane sums over rows ----
+
+RBD_KERNEL_TARGET
+void LaneCsrMultiply(int rows, int lanes, const int* ptr, const int* col, const double* a,
+    const double* x, double* y) {
+    for (int i = 0; i < rows; ++i) {
+        double* yi = y + static_cast<std::ptrdiff_t>(i) * lanes;
+        int s = 0;
+        for (; s + W <= lanes; s += W) {
+            V acc = Zero();
+            for (int e = ptr[i]; e < ptr[i + 1]; ++e)
+                acc = Fmadd(Load(a + static_cast<std::ptrdiff_t>(e) * lanes + s),
+                    Load(x + static_cast<std::ptrdiff_t>(col[e]) * lanes + s), acc);
+            Store(yi + s, acc);
+        }
+        for (; s < lanes; ++s) {
+            double acc = 0.0;
+            for (int e = ptr[i]; e < ptr[i + 1]; ++e)
+                acc += a[static_cast<std::ptrdiff_t>(e) * lanes + s] * x[static_cast<std::ptrdiff_t>(col[e]) * lanes + s];
+            yi[s] = acc;
+        }
+    }
+}
+
+RBD_KERNEL_TARGET
+void LaneWaxpy(int rows, int lanes, double* w, const double* x, const double* a, const double* y) {
+    for (int i = 0; i < rows; ++i) {
+        const std::ptrdiff_t o = static_cast<std::ptrdiff_t>(i) * lanes;
+        int s = 0;
+        for (; s + W <= lanes; s += W)
+            Store(w + o + s, Fmadd(Load(a + s), Load(y + o + s), Load(x + o + s)));
+        for (; s < lanes; ++s)
+            w[o + s] = x[o + s] + a[s] * y[o + s];
+    }
+}
+
+RBD_KERNEL_TARGET
+void LaneGradientObjective(int rows, int lanes, double* g, const double* r, const double* y, double* out) {
+    const V half = Set1(0.5);
+    int s = 0;
+    for (; s + W <= lanes; s += W) {
+        V acc = Zero();
+        for (int i = 0; i < rows; ++i) {
+            const std::ptrdiff_t o = static_cast<std::ptrdiff_t>(i) * lanes + s;
+            const V vr = Load(r + o);
+            const V vg = Add(Load(g + o), vr);
+            Store(g + o, vg);
+            acc = Fmadd(Load(y + o), Add(vg, vr), acc);
+        }
+        Store(out + s, Mul(half, acc));
+    }
+    for (; s < lanes; ++s) {
+        double acc = 0.0;
+        for (int i = 0; i < rows; ++i) {
+            const std::ptrdiff_t o = static_cast<std::ptrdiff_t>(i) * lanes + s;
+            g[o] += r[o];
+            acc += y[o] * (g[o] + r[o]);
+        }
+        out[s] = 0.5 * acc;
+    }
+}
+
+RBD_KERNEL_TARGET
+void LaneBacktrackTerms(int rows, int lanes, const double* x, const double* y, const double* Nx,
+    const double* r, const double* g, double* out) {
+    const V half = Set1(0.5);
+    int s = 0;
+    for (; s + W <= lanes; s += W) {
+        V a0 = Zero(), a1 = Zero(), a2 = Zero();
+        for (int i = 0; i < rows; ++i) {
+            const std::ptrdiff_t o = static_cast<std::ptrdiff_t>(i) * lanes + s;
+            const V vx = Load(x + o);
+            const V d = Sub(vx, Load(y + o));
+            a0 = Fmadd(vx, Fmadd(half, Load(Nx + o), Load(r + o)), a0);
+            a1 = Fmadd(Load(g + o), d, a1);
+            a2 = Fmadd(d, d, a2);
+        }
+        Store(out + s, a0);
+        Store(out + lanes + s, a1);
+        Store(out + 2 * lanes + s, a2);
+    }
+    for (; s < lanes; ++s) {
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0;
+        for (int i = 0; i < rows; ++i) {
+            const std::ptrdiff_t o = static_cast<std::ptrdiff_t>(i) * lanes + s;
+            const double d = x[o] - y[o];
+            s0 += x[o] * (0.5 * Nx[o] + r[o]);
+            s1 += g[o] * d;
+            s2 += d * d;
+        }
+        out[s] = s0;
+        out[lanes + s] = s1;
+        out[2 * lanes + s] = s2;
+    }
+}
+
+RBD_KERNEL_TARGET
+void LaneExtrapolate(int rows, int lanes, const double* x, const double* x_old, const double* beta,
+    const double* g, double* y_new, double* out) {
+    int s = 0;
+    for (; s + W <= lanes; s += W) {
+        const V vb = Load(beta + s);
+        V a0 = Zero(), a1 = Zero();
+        for (int i = 0; i < rows; ++i) {
+            const std::ptrdiff_t o = static_cast<std::ptrdiff_t>(i) * lanes + s;
+            const V vx = Load(x + o);
+            const V d = Sub(vx, Load(x_old + o));
+            Store(y_new + o, Fmadd(vb, d, vx));
+            a0 = Fmadd(d, d, a0);
+            a1 = Fmadd(Load(g + o), d, a1);
+        }
+        Store(out + s, a0);
+        Store(out + lanes + s, a1);
+    }
+    for (; s < lanes; ++s) {
+        double s0 = 0.0, s1 = 0.0;
+        for (int i = 0; i < rows; ++i) {
+            const std::ptrdiff_t o = static_cast<std::ptrdiff_t>(i) * lanes + s;
+            const double d = x[o] - x_old[o];
+            y_new[o] = x[o] + beta[s] * d;
+            s0 += d * d;
+            s1 += g[o] * d;
+        }
+        out[s] = s0;
+        out[lanes + s] = s1;
+    }
+}
+
+RBD_KERNEL_TARGET
+void LaneDistSquared(int rows, int lanes, const double* x, const double* y, double* out) {
+    int s = 0;
+    for (; s + W <= lanes; s += W) {
+        V acc = Zero();
+        for (int i = 0; i < rows; ++i) {
+            const std::ptrdiff_t o = static_cast<std::ptrdiff_t>(i) * lanes + s;
+            const V d = Sub(Load(x + o), Load(y + o));
+            acc = Fmadd(d, d, acc);
+        }
+        Store(out + s, acc);
+    }
+    for (; s < lanes; ++s) {
+        double acc = 0.0;
+        for (int i = 0; i < rows; ++i) {
+            const std::ptrdiff_t o = static_cast<std::ptrdiff_t>(i) * lanes + s;
+            const double d = x[o] - y[o];
+            acc += d * d;
+        }
+        out[s] = acc;
+    }
+}
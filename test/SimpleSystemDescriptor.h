@@ -2,20 +2,76 @@
 #include "../RBDInterface/RBDSystemDescriptor.h"
 #include "../Wrapper/MyRBDConstraint.h"
 #include "../Wrapper/MyRBDVariables.h"
+#include "../solver/include/RBDConstraintBatches.h"
+#include "../solver/include/RBDBodyMassBatch.h"
+#include "../solver/include/RBDThreadPool.h"
+#include "../solver/include/RBDStepArena.h"
 #include <vector>
 #include <cassert>
+#include <utility>
 
 namespace VSLibRBDynamX {
 
-    /// 一个非常简单的系统描述器：1 个变量、1 个约束
+    /// 一个简单的系统描述器：全部通过虚接口访问变量和约束
     class SimpleSystemDescriptor : public RBDSystemDescriptor {
     public:
         void AddVariables(RBDVariables* v) override {
             vars.push_back(v);
+            MarkTopologyChanged();
         }
         void AddConstraint(RBDConstraint* c) override {
-            cons.push_back(c);
+            // 持久约束始终排在本步临时约束之前，步末只需截掉尾部
+            c->SetIndex(static_cast<int>(cons.size()) - n_transient);
+            cons.insert(cons.end() - n_transient, c);
+            MarkTopologyChanged();
         }
+
+        // 移除持久约束：最后一个持久约束补到它的位置，最后一个临时约束补到空出的持久末位，
+        // 再截掉末尾，O(1)（临时约束之间的顺序可能改变；它们在 EndStep 时整体移除）
+        bool RemoveConstraint(RBDConstraint* c) override {
+            const int n_persistent = static_cast<int>(cons.size()) - n_transient;
+            const int i = c->GetIndex();
+            if (i < 0 || i >= n_persistent || cons[i] != c)
+                return false;
+            cons[i] = cons[n_persistent - 1];
+            cons[i]->SetIndex(i);
+            cons[n_persistent - 1] = cons.back();
+            cons.pop_back();
+            c->SetIndex(-1);
+            MarkTopologyChanged();
+            return true;
+        }
+
+        /// 在通道 lane 上从步作用域内存池创建一个只在本步有效的约束（如接触）。
+        /// 不同线程使用不同 lane 时可以并发调用；这些约束在下一次
+        /// UpdateCountsAndOffsets() 时并入 GetConstraints()，在 EndStep() 时整体释放。
+        template <class T, class... Args>
+        T* AddTransientConstraint(int lane, Args&&... args) {
+            T* c = arena.Create<T>(lane, std::forward<Args>(args)...);
+            lane_cons[lane].push_back(c);
+            return c;
+        }
+
+        /// 设置临时约束的分配通道数（通常等于生成接触的线程数，须在 EndStep 之后调用）
+        void SetNumTransientLanes(int n) {
+            EndStep();
+            arena.SetNumLanes(n);
+            lane_cons.resize(arena.GetNumLanes());
+        }
+
+        /// 步末：移除本步所有临时约束，内存池 O(1) 复位（内存块留给下一步）
+        void EndStep() {
+            if (n_transient > 0)
+                MarkTopologyChanged();
+            cons.resize(cons.size() - n_transient);
+            n_transient = 0;
+            for (auto& l : lane_cons)
+                l.clear();
+            arena.Reset();
+        }
+
+        RBDStepArena& GetStepArena() { return arena; }
+
         const std::vector<RBDVariables*>& GetVariables() const override {
             return vars;
         }
@@ -23,44 +79,146 @@ namespace VSLibRBDynamX {
             return cons;
         }
 
-        // 构建 Z (1×1) 和 d (1)
+        // 并入本步临时约束，分配变量偏移，重建约束分桶、λ 偏移与 Jacobian 块
+        void UpdateCountsAndOffsets() override {
+            for (auto& l : lane_cons) {
+                cons.insert(cons.end(), l.begin(), l.end());
+                n_transient += static_cast<int>(l.size());
+                l.clear();
+            }
+
+            n_dofs = 0;
+            bodies.Clear();
+            generic_vars.clear();
+            for (auto* v : vars) {
+                v->SetOffset(n_dofs);
+                n_dofs += v->GetDOF();
+                // 刚体的质量逆交给 SoA 批量，其余变量走虚接口
+                if (auto* b = dynamic_cast<RBDVariablesBody*>(v))
+                    bodies.Add(b);
+                else
+                    generic_vars.push_back(v);
+            }
+            batches.Setup(cons);
+            batches.Assemble(cons);
+        }
+
+        // 拓扑不变：只刷新刚体质量、Jacobian 块与偏置。
+        // 有新的临时约束待并入时拓扑已变，改为完整重建并更新版本戳
+        void UpdateValues() override {
+            for (auto& l : lane_cons) {
+                if (!l.empty()) {
+                    MarkTopologyChanged();
+                    UpdateCountsAndOffsets();
+                    return;
+                }
+            }
+            bodies.UpdateValues(IsIncrementalUpdate());
+            batches.AssembleValues(cons, IsIncrementalUpdate());
+        }
+
+        int CountActiveConstraints() const override {
+            return batches.GetNumRows();
+        }
+
+        int CountActiveVariables() const override {
+            return n_dofs;
+        }
+
+        // 按类型批量投影
+        void ConstraintsProject(std::vector<double>& lambda) const override {
+            batches.Project(lambda);
+        }
+
+        void GetProjectionLayout(int& bilateral_end, int& unilateral_end) const override {
+            bilateral_end = batches.GetEnd(RBDProjectionType::BILATERAL);
+            unilateral_end = batches.GetEnd(RBDProjectionType::UNILATERAL);
+        }
+
+        // result = D * M^{-1} * D^T * λ + E * λ
+        void SchurComplementProduct(const std::vector<double>& lambda,
+            std::vector<double>& result) const override {
+            ComputeVelocities(lambda);
+            result.resize(batches.GetNumRows());
+            batches.Multiply(v_glob.data(), result.data());
+            batches.AddComplianceProduct(lambda.data(), result.data());
+        }
+
+        void BuildBiVector(std::vector<double>& b) const override {
+            batches.BuildBiVector(b);
+        }
+
+        // 构建稠密 Z = N（逐列调用 Schur 补乘积）和 d = b
         void BuildSystemMatrix(std::vector<std::vector<double>>& Z,
             std::vector<double>& d) const override {
-            int n = 1;
+            int n = batches.GetNumRows();
             Z.assign(n, std::vector<double>(n, 0.0));
-            d.assign(n, 0.0);
-
-            // 简化：Z = [1.0]，d = [bias]
-            Z[0][0] = 1.0;
-            // 把所有约束的 bias 累加到 d
-            for (auto* c : cons)
-                d[0] += c->GetBiasTerm();
+            std::vector<double> e(n, 0.0), col;
+            for (int j = 0; j < n; ++j) {
+                e[j] = 1.0;
+                SchurComplementProduct(e, col);
+                for (int i = 0; i < n; ++i)
+                    Z[i][j] = col[i];
+                e[j] = 0.0;
+            }
+            BuildBiVector(d);
         }
 
         // y = Z * x
         void SystemProduct(const std::vector<double>& x,
             std::vector<double>& y) const override {
-            assert(x.size() == 1);
-            y.resize(1);
-            y[0] = x[0] * 1.0;
+            assert(static_cast<int>(x.size()) == batches.GetNumRows());
+            SchurComplementProduct(x, y);
         }
 
         // 只构建 bias 部分
         void BuildDiVector(std::vector<double>& di) const override {
-            di.assign(1, 0.0);
-            for (auto* c : cons)
-                di[0] += c->GetBiasTerm();
+            BuildBiVector(di);
         }
 
-        // 将解写回变量
+        // 将 v = M^{-1} D^T λ 写回变量
         void SetUnknowns(const std::vector<double>& sol) override {
-            assert(sol.size() == 1);
-            vars[0]->SetState(sol);
+            assert(static_cast<int>(sol.size()) == batches.GetNumRows());
+            ComputeVelocities(sol);
+            RBDGetThreadPool().ParallelFor(0, static_cast<int>(vars.size()), 256, [&](int b, int e) {
+                for (int i = b; i < e; ++i)
+                    vars[i]->SetState(RBDSpan<const double>(v_glob.data() + vars[i]->GetOffset(), vars[i]->GetDOF()));
+            });
         }
 
+        /// 约束批量存储：λ 布局、D^T λ 累加方式与并行装配统计（UpdateCountsAndOffsets 后有效）
+        const RBDConstraintBatches& GetConstraintBatches() const { return batches; }
+
     private:
+        // v_glob = M^{-1} D^T λ
+        void ComputeVelocities(const std::vector<double>& lambda) const {
+            v_glob.assign(n_dofs, 0.0);
+            batches.MultiplyTranspose(lambda.data(), v_glob.data(), acc);
+            bodies.Apply(v_glob.data());
+            // 原地计算：直接在全局速度缓冲的片段上做 M^{-1} f，各变量片段互不重叠，可并行
+            RBDGetThreadPool().ParallelFor(0, static_cast<int>(generic_vars.size()), 256, [&](int b, int e) {
+                for (int i = b; i < e; ++i) {
+                    const RBDVariables* v = generic_vars[i];
+                    double* p = v_glob.data() + v->GetOffset();
+                    v->ComputeMassInverseTimesVector(RBDSpan<const double>(p, v->GetDOF()),
+                        RBDSpan<double>(p, v->GetDOF()));
+                }
+            });
+        }
+
         std::vector<RBDVariables*> vars;
         std::vector<RBDConstraint*> cons;
+        RBDConstraintBatches batches;
+        RBDBodyMassBatch bodies;                  ///< 刚体质量逆的 SoA 批量
+        std::vector<RBDVariables*> generic_vars;  ///< 其余需要虚调用质量逆的变量
+        int n_dofs = 0;
+
+        RBDStepArena arena;                                 ///< 临时约束的步作用域内存池
+        std::vector<std::vector<RBDConstraint*>> lane_cons{ 1 };  ///< 各通道本步新建、尚未并入的约束
+        int n_transient = 0;                                ///< cons 尾部临时约束的个数
+
+        mutable std::vector<double> v_glob;  ///< 全局速度缓冲
+        mutable std::vector<double> acc;     ///< D^T λ 的 ACCUMULATE 累加缓冲
     };
 
 } // namespace
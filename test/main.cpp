@@ -3,8 +3,15 @@
 
 #include "../Wrapper/MyRBDVariables.h"
 #include "../Wrapper/MyRBDConstraint.h"
+#include "../Wrapper/MyRBDHostVariables.h"
+#include "../Wrapper/MyRBDHostConstraint.h"
+#include "../RBDInterface/RBDVariablesBody.h"
 #include "SimpleSystemDescriptor.h"
 #include "../solver/include/RBDSolverAPGD.h"
+#include "../solver/include/RBDStaticSystemDescriptor.h"
+#include "../solver/include/RBDSimd.h"
+#include "../solver/include/RBDStepPipeline.h"
+#include "../solver/include/RBDSolverEnsembleAPGD.h"
 
 using namespace VSLibRBDynamX;
 
@@ -42,5 +49,191 @@ int main() {
     std::cout << "Solution x = " << x
         << " (expected = " << -bias << ")\n";
 
+    // 7) 同一问题改用编译期特化的描述器，APGD 主循环中的调用全部静态绑定
+    MyRBDVariables var2(2.0);
+    MyRBDConstraint cons2(&var2, bias);
+    RBDStaticSystemDescriptor<RBDTypeList<MyRBDVariables>, RBDTypeList<MyRBDConstraint>> static_sys;
+    static_sys.Add(&var2);
+    static_sys.Add(&cons2);
+
+    double residual2 = solver.SolveSpecialized(static_sys);
+    var2.GetState(sol);
+    std::cout << "APGD (static descriptor) residual = " << residual2
+        << ", x = " << (sol.empty() ? 0.0 : sol[0]) << "\n";
+
+    // 8) 变量直接映射“宿主引擎”的数组，求解结果经零拷贝接口写回宿主内存
+    double host_vel[1] = { 0.0 };
+    const double host_inv_mass[1] = { 0.5 };
+    MyRBDHostVariables var3(host_vel, host_inv_mass, 1);
+    MyRBDConstraint cons3(&var3, bias);
+    SimpleSystemDescriptor host_sys;
+    host_sys.AddVariables(&var3);
+    host_sys.AddConstraint(&cons3);
+
+    double residual3 = solver.Solve(host_sys);
+    std::cout << "APGD (host arrays) residual = " << residual3
+        << ", host_vel[0] = " << host_vel[0] << "\n";
+
+    // 9) 6 自由度刚体：质量逆由描述器按 SoA 批量（运行时选择 SIMD 指令集）计算
+    RBDVariablesBody body;
+    body.SetBodyMass(2.0);
+    MyRBDConstraint cons4(&body, bias);
+    SimpleSystemDescriptor body_sys;
+    body_sys.AddVariables(&body);
+    body_sys.AddConstraint(&cons4);
+
+    double residual4 = solver.Solve(body_sys);
+    std::cout << "APGD (6-DOF body, " << RBDSimdLevelName(RBDGetSimdLevel()) << ") residual = " << residual4
+        << ", v_x = " << body.GetStateN()[0] << "\n";
+
+    // 10) 异步求解：快照建立后立即返回，宿主可以先做别的工作，Join 时才写回变量
+    MyRBDVariables var5(2.0);
+    MyRBDConstraint cons5(&var5, bias);
+    SimpleSystemDescriptor async_sys;
+    async_sys.AddVariables(&var5);
+    async_sys.AddConstraint(&cons5);
+
+    RBDSolveHandle handle = solver.SolveAsync(async_sys);
+    // ……此处可以进行渲染、下一步的碰撞检测或另一个场景的求解……
+    double residual5 = handle.Join();
+    var5.GetState(sol);
+    std::cout << "APGD (async) residual = " << residual5
+        << ", x = " << (sol.empty() ? 0.0 : sol[0]) << "\n";
+
+    // 11) 多岛流水线：岛 k+1 的装配与岛 k 的求解、岛 k-1 的写回在线程池上重叠
+    std::vector<MyRBDVariables> island_vars(3, MyRBDVariables(2.0));
+    std::vector<MyRBDConstraint> island_cons;
+    std::vector<SimpleSystemDescriptor> island_sys(island_vars.size());
+    for (std::size_t k = 0; k < island_vars.size(); ++k)
+        island_cons.emplace_back(&island_vars[k], bias);
+    RBDStepPipeline pipeline;
+    pipeline.GetSolverSettings().SetMaxIterations(100);
+    pipeline.GetSolverSettings().SetTolerance(1e-6);
+    for (std::size_t k = 0; k < island_vars.size(); ++k) {
+        island_sys[k].AddVariables(&island_vars[k]);
+        island_sys[k].AddConstraint(&island_cons[k]);
+        pipeline.AddIsland(&island_sys[k]);
+    }
+    pipeline.Step();
+    std::cout << "APGD (pipeline) islands = " << pipeline.GetNumIslands() << ", x =";
+    for (auto& v : island_vars) {
+        v.GetState(sol);
+        std::cout << " " << (sol.empty() ? 0.0 : sol[0]);
+    }
+    std::cout << "\n";
+
+    // 12) 集合求解：结构相同、参数不同的多个场景（如参数扫描）按 [约束][场景] 交错一次求解
+    const int num_scenes = 10;
+    std::vector<MyRBDVariables> scene_vars(num_scenes, MyRBDVariables(2.0));
+    std::vector<MyRBDConstraint> scene_cons;
+    std::vector<SimpleSystemDescriptor> scene_sys(num_scenes);
+    std::vector<RBDSystemDescriptor*> scenes;
+    for (int k = 0; k < num_scenes; ++k)
+        scene_cons.emplace_back(&scene_vars[k], -(k + 1.0));  // 场景 k 的解为 x = k + 1
+    for (int k = 0; k < num_scenes; ++k) {
+        scene_sys[k].AddVariables(&scene_vars[k]);
+        scene_sys[k].AddConstraint(&scene_cons[k]);
+        scenes.push_back(&scene_sys[k]);
+    }
+    RBDSolverEnsembleAPGD ensemble;
+    ensemble.SetMaxIterations(100);
+    ensemble.SetTolerance(1e-6);
+    double residual6 = ensemble.Solve(scenes);
+    std::cout << "APGD (ensemble) scenes = " << num_scenes << ", max residual = " << residual6 << ", x =";
+    for (auto& v : scene_vars) {
+        v.GetState(sol);
+        std::cout << " " << (sol.empty() ? 0.0 : sol[0]);
+    }
+    std::cout << "\n";
+
+    // 13) 限时求解：硬实时（如 HIL）场合给每步一个时间预算，超时即返回目前的最优解；
+    //     每轮耗时统计把下一步的迭代上限收紧到预算之内，之后的步不再需要靠时钟打断
+    const int chain = 200;
+    const double anchor[1] = { 1.0 };
+    const double link[2] = { 1.0, -1.0 };
+    std::vector<MyRBDVariables> chain_vars(chain, MyRBDVariables(1.0));
+    std::vector<MyRBDHostConstraint> chain_cons;
+    chain_cons.reserve(chain);
+    chain_cons.emplace_back(&chain_vars[0], nullptr, 1, anchor, -1.0, RBDProjectionType::BILATERAL);
+    for (int i = 0; i + 1 < chain; ++i)
+        chain_cons.emplace_back(&chain_vars[i], &chain_vars[i + 1], 1, link, 0.0, RBDProjectionType::BILATERAL);
+    SimpleSystemDescriptor chain_sys;
+    for (auto& v : chain_vars)
+        chain_sys.AddVariables(&v);
+    for (auto& c : chain_cons)
+        chain_sys.AddConstraint(&c);
+
+    RBDSolverAPGD rt_solver;
+    rt_solver.SetMaxIterations(100000);
+    rt_solver.SetTolerance(1e-12);
+    rt_solver.SetTimeBudget(1e-3);  // 1 ms
+    for (int step = 0; step < 3; ++step) {
+        rt_solver.Solve(chain_sys);
+        std::cout << "APGD (1 ms budget) step " << step << ": iterations = " << rt_solver.GetIterations()
+            << ", budget exceeded = " << rt_solver.IsBudgetExceeded()
+            << ", next iteration cap = " << rt_solver.GetIterationCap()
+            << ", structure reused = " << rt_solver.IsSetupReused() << "\n";
+    }
+
+    // 14) 拓扑不变时的结构复用：上面后两步只刷新了数值（与完整重建逐位相同，见 test_incremental_update）
+    // 15) 增量更新：只重新装配调用过 MarkDirty() 的约束（SetCompliance 会自动标记）；
+    //     移除约束为 O(1)，下一次求解重建结构
+    rt_solver.SetTimeBudget(0.0);
+    rt_solver.SetMaxIterations(200);
+    chain_sys.SetIncrementalUpdate(true);
+    chain_cons[chain / 2].SetCompliance(1e-3);
+    rt_solver.Solve(chain_sys);
+    std::cout << "APGD incremental update: re-assembled " << chain_sys.GetConstraintBatches().GetNumAssembled()
+        << " of " << chain_sys.GetConstraints().size() << " constraints, structure reused = "
+        << rt_solver.IsSetupReused();
+    chain_cons[chain / 2].SetCompliance(0.0);
+    chain_sys.RemoveConstraint(&chain_cons.back());
+    rt_solver.Solve(chain_sys);
+    std::cout << ", after removing one: " << chain_sys.GetConstraints().size()
+        << " constraints, structure reused = " << rt_solver.IsSetupReused() << "\n";
+
+    // 16) 柔性约束：每节链环用两个双边约束（冗余关节），两者的偏置略有出入。
+    //     刚性时约束互相矛盾、无解，迭代跑满上限；给一个小柔度后 N + E 正定，解唯一且很快收敛
+    const int redundant = 5;
+    std::vector<MyRBDVariables> soft_vars(redundant, MyRBDVariables(1.0));
+    std::vector<MyRBDHostConstraint> soft_cons;
+    soft_cons.reserve(2 * redundant);
+    soft_cons.emplace_back(&soft_vars[0], nullptr, 1, anchor, -1.0, RBDProjectionType::BILATERAL);
+    for (int i = 0; i + 1 < redundant; ++i)
+        for (int k = 0; k < 2; ++k)
+            soft_cons.emplace_back(&soft_vars[i], &soft_vars[i + 1], 1, link, 0.01 * k, RBDProjectionType::BILATERAL);
+    SimpleSystemDescriptor soft_sys;
+    for (auto& v : soft_vars)
+        soft_sys.AddVariables(&v);
+    for (auto& c : soft_cons)
+        soft_sys.AddConstraint(&c);
+
+    RBDSolverAPGD soft_solver;
+    soft_solver.SetMaxIterations(2000);
+    soft_solver.SetTolerance(1e-6);
+    for (double compliance : { 0.0, 1e-3, 1e-2 }) {
+        for (auto& c : soft_cons)
+            c.SetCompliance(compliance);
+        soft_solver.Solve(soft_sys);
+        std::cout << "APGD redundant joints, compliance = " << compliance << ": iterations = "
+            << soft_solver.GetIterations() << ", residual = " << soft_solver.GetError() << "\n";
+    }
+
+    // 17) 初始 L：默认由 N 作用在全 1 向量上粗估，链条这类问题会严重低估，开头几轮连续回溯；
+    //     幂迭代估计以上一步的特征向量为初值，估计值逐步逼近最大特征值（此链条为 4）
+    for (bool estimate : { false, true }) {
+        RBDSolverAPGD l_solver;
+        l_solver.SetMaxIterations(5);
+        l_solver.EnableLipschitzEstimate(estimate);
+        std::cout << "APGD " << (estimate ? "power-iteration" : "default") << " initial L, backtracks in the first 5 iterations:";
+        for (int step = 0; step < 3; ++step) {
+            l_solver.Solve(chain_sys);
+            std::cout << " " << l_solver.GetBacktracks();
+        }
+        if (estimate)
+            std::cout << ", largest eigenvalue estimate = " << l_solver.GetLipschitzEstimator().GetEstimate();
+        std::cout << "\n";
+    }
+
     return 0;
 }
@@ -0,0 +1,174 @@
+﻿// 结构复用与增量更新：拓扑不变时只刷新数值（UpdateValues，可只刷新版本戳变化过的约束与刚体），
+// 移除约束后重建结构；每一步的 λ 与速度都须与同样顺序的新描述器、新求解器完整重建的结果逐位相同
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "../Wrapper/MyRBDHostConstraint.h"
+#include "../RBDInterface/RBDVariablesBody.h"
+#include "SimpleSystemDescriptor.h"
+#include "../solver/include/RBDSolverAPGD.h"
+#include "../solver/include/RBDStaticSystemDescriptor.h"
+
+using namespace VSLibRBDynamX;
+
+namespace {
+
+    using StaticDescriptor = RBDStaticSystemDescriptor<RBDTypeList<RBDVariablesBody>, RBDTypeList<MyRBDHostConstraint>>;
+
+    /// 一次求解的结果：λ（描述器的布局）与各刚体写回的速度
+    struct Result {
+        std::vector<double> lambda;
+        std::vector<double> velocity;
+    };
+
+    void ConfigureSolver(RBDSolverAPGD& solver) {
+        solver.SetMaxIterations(60);
+        solver.SetTolerance(0.0);  // 固定迭代次数，两边走完全相同的迭代
+    }
+
+    Result Collect(const RBDSolverAPGD& solver, const std::vector<RBDVariablesBody>& bodies) {
+        Result r;
+        solver.Dump_Lambda(r.lambda);
+        std::vector<double> state;
+        for (const auto& b : bodies) {
+            b.GetState(state);
+            r.velocity.insert(r.velocity.end(), state.begin(), state.end());
+        }
+        return r;
+    }
+
+    bool Identical(const std::vector<double>& a, const std::vector<double>& b) {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+    }
+
+    /// 用新描述器、新求解器按 sysd 当前的约束顺序完整重建并求解
+    template <class TDescriptor>
+    Result SolveRebuilt(const TDescriptor& sysd, std::vector<RBDVariablesBody>& bodies) {
+        TDescriptor fresh;
+        for (auto* v : sysd.GetVariables())
+            fresh.AddVariables(v);
+        for (auto* c : sysd.GetConstraints())
+            fresh.AddConstraint(c);
+        RBDSolverAPGD solver;
+        ConfigureSolver(solver);
+        solver.Solve(fresh);
+        return Collect(solver, bodies);
+    }
+
+    template <class TDescriptor>
+    int Run(const char* name, bool incremental) {
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+        // 刚体链：跨越多个 512 体的质量逆块，使增量刷新落在不同块里
+        const int n = 1100;
+        std::vector<RBDVariablesBody> bodies(n);
+        for (auto& b : bodies) {
+            b.SetBodyMass(2.0 + dist(rng));
+            const double a = 0.1 * dist(rng);
+            b.SetBodyInvInertia({ 1.5 + dist(rng), a, 0.0,
+                                  a, 1.5 + dist(rng), 0.0,
+                                  0.0, 0.0, 1.5 + dist(rng) });
+        }
+
+        // 约束：一个锚定、相邻刚体之间的双边约束、隔几个刚体一个单边接触和一个摩擦接触
+        std::vector<double> jacobian;
+        jacobian.reserve(40 * n);  // 约束保存指向此数组的指针，不能重新分配
+        std::vector<std::size_t> jacobian_at;
+        std::vector<MyRBDHostConstraint> cons;
+        cons.reserve(2 * n);
+        auto add = [&](int a, int b, int dim, RBDProjectionType type, double bias, double mu) {
+            const std::size_t at = jacobian.size();
+            jacobian_at.push_back(at);
+            const int cols = b < 0 ? 6 : 12;
+            for (int k = 0; k < dim * cols; ++k)
+                jacobian.push_back(dist(rng));
+            cons.emplace_back(&bodies[a], b < 0 ? nullptr : &bodies[b], dim, jacobian.data() + at, bias, type, mu);
+        };
+        add(0, -1, 1, RBDProjectionType::BILATERAL, -1.0, 0.0);
+        for (int i = 0; i + 1 < n; ++i)
+            add(i, i + 1, 1, RBDProjectionType::BILATERAL, 0.1 * dist(rng), 0.0);
+        for (int i = 0; i < n; i += 3)
+            add(i, -1, 1, RBDProjectionType::UNILATERAL, -0.2 + 0.1 * dist(rng), 0.0);
+        for (int i = 1; i < n; i += 5)
+            add(i, -1, 3, RBDProjectionType::FRICTION_CONE, -0.2 + 0.1 * dist(rng), 0.5);
+
+        TDescriptor sysd;
+        sysd.SetIncrementalUpdate(incremental);
+        for (auto& b : bodies)
+            sysd.AddVariables(&b);
+        for (auto& c : cons)
+            sysd.AddConstraint(&c);
+
+        RBDSolverAPGD solver;
+        ConfigureSolver(solver);
+        int failures = 0;
+        auto check = [&](const char* step, bool expect_reused, int max_assembled) {
+            solver.Solve(sysd);
+            const Result r = Collect(solver, bodies);
+            const int assembled = sysd.GetConstraintBatches().GetNumAssembled();
+            if (solver.IsSetupReused() != expect_reused) {
+                std::printf("FAIL %s incremental=%d %s: structure reused = %d, expected %d\n", name, incremental,
+                    step, solver.IsSetupReused(), expect_reused);
+                ++failures;
+            }
+            if (max_assembled >= 0 && assembled > max_assembled) {
+                std::printf("FAIL %s incremental=%d %s: re-assembled %d constraints, expected at most %d\n", name,
+                    incremental, step, assembled, max_assembled);
+                ++failures;
+            }
+            const Result ref = SolveRebuilt(sysd, bodies);
+            if (!Identical(r.lambda, ref.lambda) || !Identical(r.velocity, ref.velocity)) {
+                std::printf("FAIL %s incremental=%d %s: lambda or velocity differs from a full rebuild\n", name,
+                    incremental, step);
+                ++failures;
+            }
+        };
+
+        const int all = static_cast<int>(cons.size());
+        check("first solve", false, -1);
+
+        // 数值全未变：结构复用；增量时一个约束都不重新装配
+        check("unchanged", true, incremental ? 0 : all);
+
+        // 刚体质量与惯量改变（SetBodyMass / SetBodyInvInertia 自动更新版本戳）
+        for (int i : { 3, 600, 1099 })
+            bodies[i].SetBodyMass(0.5 * bodies[i].GetBodyMass());
+        auto inertia = bodies[700].GetBodyInvInertia();
+        inertia[0] *= 3.0;
+        inertia[4] *= 0.25;
+        bodies[700].SetBodyInvInertia(inertia);
+        check("mass and inertia changed", true, -1);
+
+        // 约束数值改变：柔度（自动标记）与宿主数组中的 Jacobian（手动 MarkDirty）
+        cons[n / 2].SetCompliance(1e-3);
+        jacobian[jacobian_at[17] + 6] += 0.5;
+        cons[17].MarkDirty();
+        check("constraint values changed", true, incremental ? 2 : all);
+
+        // 移除约束：拓扑改变，结构重建
+        sysd.RemoveConstraint(&cons[n / 3]);
+        sysd.RemoveConstraint(&cons.back());
+        check("constraints removed", false, -1);
+
+        // 移除之后再改质量：回到结构复用
+        bodies[n / 3].SetBodyMass(4.0);
+        check("mass changed after removal", true, -1);
+        return failures;
+    }
+
+} // namespace
+
+int main() {
+    int failures = 0;
+    for (bool incremental : { false, true }) {
+        failures += Run<SimpleSystemDescriptor>("SimpleSystemDescriptor", incremental);
+        failures += Run<StaticDescriptor>("RBDStaticSystemDescriptor", incremental);
+    }
+    if (failures == 0)
+        std::printf("structure reuse and incremental updates match a full rebuild bit for bit\n");
+    return failures == 0 ? 0 : 1;
+}
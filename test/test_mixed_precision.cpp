@@ -0,0 +1,73 @@
+﻿// 检查混合精度（单精度迭代 + 双精度精化）与纯双精度求解在容差内一致，
+// 包括不做精化（SetRefinementIterations(0)）时直接采用单精度结果
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../Wrapper/MyRBDVariables.h"
+#include "../Wrapper/MyRBDConstraint.h"
+#include "SimpleSystemDescriptor.h"
+#include "../solver/include/RBDSolverAPGD.h"
+
+using namespace VSLibRBDynamX;
+
+namespace {
+
+    struct Result {
+        std::vector<double> lambda;
+        double residual = 0.0;
+    };
+
+    /// 随机质量与偏置的单变量约束，各约束互不耦合
+    Result SolveScene(bool mixed, int refine) {
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+        const int n = 200;
+        std::vector<MyRBDVariables> vars;
+        vars.reserve(n);
+        std::vector<MyRBDConstraint> cons;
+        cons.reserve(n);
+        SimpleSystemDescriptor sys;
+        for (int i = 0; i < n; ++i) {
+            vars.emplace_back(2.0 + dist(rng));
+            sys.AddVariables(&vars.back());
+        }
+        for (int i = 0; i < n; ++i) {
+            cons.emplace_back(&vars[i], dist(rng));
+            sys.AddConstraint(&cons.back());
+        }
+
+        RBDSolverAPGD solver;
+        solver.SetMaxIterations(500);
+        solver.SetTolerance(1e-6);
+        solver.EnableMixedPrecision(mixed);
+        solver.SetRefinementIterations(refine);
+        Result result;
+        result.residual = solver.Solve(sys);
+        solver.Dump_Lambda(result.lambda);
+        return result;
+    }
+
+} // namespace
+
+int main() {
+    int failures = 0;
+    const Result reference = SolveScene(false, 0);
+    // 不精化时结果只能精确到单精度阶段的水平；精化后应与双精度求解同样满足容差
+    struct Case { int refine; double lambda_tol; double residual_tol; };
+    for (const Case& c : { Case{ 0, 1e-3, 1e-2 }, Case{ 20, 1e-5, 1e-6 } }) {
+        const Result mixed = SolveScene(true, c.refine);
+        double diff = 0.0;
+        for (std::size_t i = 0; i < reference.lambda.size() && i < mixed.lambda.size(); ++i)
+            diff = std::fmax(diff, std::fabs(mixed.lambda[i] - reference.lambda[i]));
+        if (mixed.lambda.size() != reference.lambda.size() || !(diff < c.lambda_tol) ||
+            !(mixed.residual < c.residual_tol)) {
+            std::printf("FAIL refine=%d: max |lambda diff| = %g, residual = %g\n", c.refine, diff, mixed.residual);
+            ++failures;
+        }
+    }
+    if (failures == 0)
+        std::printf("mixed-precision lambda matches the double solve with 0 and 20 refinement iterations\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,311 @@
+﻿// 求解器各项功能的行为检查：异步求解与取消、多岛流水线、时间预算、柔性约束、Lipschitz 估计
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "../Wrapper/MyRBDVariables.h"
+#include "../Wrapper/MyRBDHostConstraint.h"
+#include "SimpleSystemDescriptor.h"
+#include "../solver/include/RBDSolverAPGD.h"
+#include "../solver/include/RBDStepPipeline.h"
+#include "../solver/include/RBDThreadPool.h"
+
+using namespace VSLibRBDynamX;
+
+namespace {
+
+    const double ANCHOR[1] = { 1.0 };
+    const double LINK[2] = { 1.0, -1.0 };
+
+    /// 单自由度链：0 号变量锚定在 x = 1，相邻变量之间 x_i - x_{i+1} + b_i = 0
+    struct Chain {
+        explicit Chain(int n, double mass = 1.0) : vars(n, MyRBDVariables(mass)) {
+            cons.reserve(n);
+            cons.emplace_back(&vars[0], nullptr, 1, ANCHOR, -1.0, RBDProjectionType::BILATERAL);
+            for (int i = 0; i + 1 < n; ++i)
+                cons.emplace_back(&vars[i], &vars[i + 1], 1, LINK, 0.01 * (i % 7), RBDProjectionType::BILATERAL);
+            for (auto& v : vars)
+                sys.AddVariables(&v);
+            for (auto& c : cons)
+                sys.AddConstraint(&c);
+        }
+
+        /// 各变量写回的速度
+        std::vector<double> State() const {
+            std::vector<double> x, s;
+            for (const auto& v : vars) {
+                v.GetState(s);
+                x.insert(x.end(), s.begin(), s.end());
+            }
+            return x;
+        }
+
+        std::vector<MyRBDVariables> vars;
+        std::vector<MyRBDHostConstraint> cons;
+        SimpleSystemDescriptor sys;
+    };
+
+    bool Identical(const std::vector<double>& a, const std::vector<double>& b) {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+    }
+
+    /// 异步求解 Join 后的 λ、残差与写回的速度与同参数的同步求解逐位相同
+    int TestAsyncMatchesSync() {
+        Chain sync_chain(300), async_chain(300);
+        RBDSolverAPGD solver;
+        solver.SetMaxIterations(400);
+        solver.SetTolerance(1e-10);
+
+        const double sync_residual = solver.Solve(sync_chain.sys);
+        const int sync_iterations = solver.GetIterations();
+        std::vector<double> sync_lambda;
+        solver.Dump_Lambda(sync_lambda);
+
+        RBDSolveHandle handle = solver.SolveAsync(async_chain.sys);
+        const double async_residual = handle.Join();
+
+        int failures = 0;
+        if (async_residual != sync_residual || handle.GetIterations() != sync_iterations || handle.WasCancelled()) {
+            std::printf("FAIL async: residual %g / %d iterations, sync %g / %d\n", async_residual,
+                handle.GetIterations(), sync_residual, sync_iterations);
+            ++failures;
+        }
+        if (!Identical(handle.GetLambda(), sync_lambda) || !Identical(async_chain.State(), sync_chain.State())) {
+            std::printf("FAIL async: lambda or written-back velocity differs from the synchronous solve\n");
+            ++failures;
+        }
+        return failures;
+    }
+
+    /// Cancel 让求解远在迭代上限之前停下，Join 仍写回目前的最优解
+    int TestCancelStopsEarly() {
+        const int max_iterations = 1000000;
+        Chain chain(2000);
+        RBDSolverAPGD solver;
+        solver.SetMaxIterations(max_iterations);
+        solver.SetTolerance(0.0);  // 不会收敛：不取消就跑满上限
+
+        RBDSolveHandle handle = solver.SolveAsync(chain.sys);
+        handle.Cancel();
+        handle.Join();
+
+        int failures = 0;
+        if (!handle.WasCancelled() || handle.GetIterations() >= max_iterations / 10) {
+            std::printf("FAIL cancel: cancelled = %d after %d of %d iterations\n", handle.WasCancelled(),
+                handle.GetIterations(), max_iterations);
+            ++failures;
+        }
+        if (handle.GetLambda().size() != chain.cons.size()) {
+            std::printf("FAIL cancel: lambda has %zu entries, expected %zu\n", handle.GetLambda().size(),
+                chain.cons.size());
+            ++failures;
+        }
+        return failures;
+    }
+
+    /// 流水线中各岛的 λ、残差、迭代轮数与写回的速度与逐岛单独 Solve 逐位相同（连续两步，第二步复用结构）
+    int TestPipelineMatchesSolve() {
+        const int sizes[] = { 50, 400, 7, 1200, 90 };
+        std::vector<std::unique_ptr<Chain>> islands, reference;
+        RBDStepPipeline pipeline;
+        pipeline.GetSolverSettings().SetMaxIterations(300);
+        pipeline.GetSolverSettings().SetTolerance(1e-9);
+        for (int n : sizes) {
+            islands.push_back(std::make_unique<Chain>(n, 1.0 + 0.001 * n));
+            reference.push_back(std::make_unique<Chain>(n, 1.0 + 0.001 * n));
+            pipeline.AddIsland(&islands.back()->sys);
+        }
+
+        int failures = 0;
+        std::vector<RBDSolverAPGD> solvers(reference.size());
+        for (auto& s : solvers) {
+            s.SetMaxIterations(300);
+            s.SetTolerance(1e-9);
+        }
+        for (int step = 0; step < 2; ++step) {
+            pipeline.Step();
+            for (std::size_t k = 0; k < reference.size(); ++k) {
+                const double residual = solvers[k].Solve(reference[k]->sys);
+                std::vector<double> lambda, pipeline_lambda;
+                solvers[k].Dump_Lambda(lambda);
+                pipeline.GetIslandSolver(static_cast<int>(k)).Dump_Lambda(pipeline_lambda);
+                const RBDPipelineIslandStats& stats = pipeline.GetIslandStats(static_cast<int>(k));
+                if (stats.residual != residual || stats.iterations != solvers[k].GetIterations() ||
+                    !Identical(pipeline_lambda, lambda) || !Identical(islands[k]->State(), reference[k]->State())) {
+                    std::printf("FAIL pipeline step %d island %zu: result differs from a separate Solve\n", step, k);
+                    ++failures;
+                }
+            }
+        }
+        return failures;
+    }
+
+    /// 时间预算：超时后提前返回；按耗时统计收紧的迭代上限不超过 max_iterations
+    int TestTimeBudget() {
+        int failures = 0;
+        Chain chain(2000);
+
+        // 预算远小于跑满上限所需的时间
+        const int max_iterations = 1000000;
+        const double budget = 2e-3;
+        RBDSolverAPGD solver;
+        solver.SetMaxIterations(max_iterations);
+        solver.SetTolerance(0.0);
+        solver.SetTimeBudget(budget);
+        for (int step = 0; step < 3; ++step) {
+            const auto t0 = std::chrono::steady_clock::now();
+            solver.Solve(chain.sys);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            const int cap = solver.GetIterationCap();
+            // 第一步只能靠时钟打断；之后收紧的上限可能让求解在读时钟之前按轮数结束
+            if ((step == 0 && !solver.IsBudgetExceeded()) || solver.GetIterations() >= max_iterations ||
+                seconds > 100 * budget) {
+                std::printf("FAIL budget step %d: exceeded = %d after %d iterations in %g s\n", step,
+                    solver.IsBudgetExceeded(), solver.GetIterations(), seconds);
+                ++failures;
+            }
+            if (cap < 1 || cap > max_iterations) {
+                std::printf("FAIL budget step %d: iteration cap %d outside [1, %d]\n", step, cap, max_iterations);
+                ++failures;
+            }
+        }
+
+        // 预算充足：不超时，上限保持为 max_iterations
+        RBDSolverAPGD relaxed;
+        relaxed.SetMaxIterations(50);
+        relaxed.SetTolerance(0.0);
+        relaxed.SetTimeBudget(60.0);
+        for (int step = 0; step < 2; ++step) {
+            relaxed.Solve(chain.sys);
+            if (relaxed.IsBudgetExceeded() || relaxed.GetIterations() != 50 || relaxed.GetIterationCap() != 50) {
+                std::printf("FAIL relaxed budget step %d: exceeded = %d, %d iterations, cap %d\n", step,
+                    relaxed.IsBudgetExceeded(), relaxed.GetIterations(), relaxed.GetIterationCap());
+                ++failures;
+            }
+        }
+
+        // 预算在第一轮的回溯中就已用完（默认的初始 L 对链条严重低估，第一轮必然回溯）：
+        // 回溯循环内的检查让求解停在第 0 轮，不再等到下一次按轮数读时钟
+        RBDSolverAPGD tight;
+        tight.SetMaxIterations(1000);
+        tight.SetTolerance(0.0);
+        tight.SetTimeBudget(1e-9);
+        tight.Solve(chain.sys);
+        if (!tight.IsBudgetExceeded() || tight.GetIterations() != 0 || tight.GetBacktracks() != 0) {
+            std::printf("FAIL budget spent while backtracking: exceeded = %d, %d iterations, %d backtracks\n",
+                tight.IsBudgetExceeded(), tight.GetIterations(), tight.GetBacktracks());
+            ++failures;
+        }
+        return failures;
+    }
+
+    /// 柔性约束：单自由度 m、x + b = 0 的约束，(1/m + E) λ + s b = 0 的解析解
+    /// λ = -s b / (1/m + E)，E = α / (h (h + c α))，s = h / (h + c α)
+    int TestComplianceClosedForm() {
+        int failures = 0;
+        const double mass = 2.5;
+        const double bias = -0.8;
+        const double triples[][3] = {  // α, c, h
+            { 0.0, 0.0, 1e-2 }, { 1e-3, 0.0, 1e-2 }, { 1e-3, 50.0, 1e-2 }, { 0.2, 5.0, 1e-3 }, { 5.0, 0.1, 0.1 } };
+        for (const auto& p : triples) {
+            const double alpha = p[0], c = p[1], h = p[2];
+            MyRBDVariables var(mass);
+            MyRBDHostConstraint cons(&var, nullptr, 1, ANCHOR, bias, RBDProjectionType::BILATERAL);
+            SimpleSystemDescriptor sys;
+            sys.AddVariables(&var);
+            sys.AddConstraint(&cons);
+            if (!cons.SetComplianceDamping(alpha, c, h)) {
+                std::printf("FAIL compliance alpha=%g c=%g h=%g: rejected\n", alpha, c, h);
+                ++failures;
+                continue;
+            }
+
+            const double E = alpha / (h * (h + c * alpha));
+            const double s = h / (h + c * alpha);
+            const double expected = -s * bias / (1.0 / mass + E);
+            RBDSolverAPGD solver;
+            solver.SetMaxIterations(1000);
+            solver.SetTolerance(1e-14);
+            solver.Solve(sys);
+            std::vector<double> lambda;
+            solver.Dump_Lambda(lambda);
+            const double err = lambda.size() == 1 ? std::fabs(lambda[0] - expected) : 1.0;
+            if (std::fabs(cons.GetCompliance() - E) > 1e-15 * E || std::fabs(cons.GetBiasFactor() - s) > 1e-15 ||
+                err > 1e-10 * std::fabs(expected)) {
+                std::printf("FAIL compliance alpha=%g c=%g h=%g: E = %.17g (expected %.17g), lambda error %g\n",
+                    alpha, c, h, cons.GetCompliance(), E, err);
+                ++failures;
+            }
+        }
+
+        // 非法参数：不改动约束并返回 false
+        MyRBDVariables var(mass);
+        MyRBDHostConstraint cons(&var, nullptr, 1, ANCHOR, bias, RBDProjectionType::BILATERAL);
+        cons.SetCompliance(1e-3);
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        const double invalid[][3] = { { 1e-3, 1.0, 0.0 }, { 1e-3, 1.0, -1e-2 }, { 1e-3, 1.0, nan },
+                                      { -1e-3, 1.0, 1e-2 }, { 1e-3, -1.0, 1e-2 } };
+        for (const auto& p : invalid) {
+            if (cons.SetComplianceDamping(p[0], p[1], p[2]) || cons.GetCompliance() != 1e-3 ||
+                cons.GetBiasFactor() != 1.0) {
+                std::printf("FAIL compliance alpha=%g c=%g h=%g: invalid parameters were accepted\n", p[0], p[1], p[2]);
+                ++failures;
+            }
+        }
+        return failures;
+    }
+
+    /// 幂迭代 Lipschitz 估计：单位质量的 n 节链条 N = D D^T 与 D^T D（对角 2,…,2,1、次对角 -1 的三对角阵）
+    /// 特征值相同，最大特征值为 2 + 2 cos(2π / (2n + 1))。估计值是下界，跨步热启动后不低于 0.9 λmax
+    int TestLipschitzEstimate() {
+        const double pi = 3.14159265358979323846;
+        const int n = 200;
+        const double lambda_max = 2.0 + 2.0 * std::cos(2.0 * pi / (2 * n + 1));
+        Chain chain(n);
+
+        RBDSolverAPGD solver;
+        solver.SetMaxIterations(5);
+        solver.EnableLipschitzEstimate(true);
+        int failures = 0;
+        for (int step = 0; step < 3; ++step) {
+            solver.Solve(chain.sys);
+            const double estimate = solver.GetLipschitzEstimator().GetEstimate();
+            if (estimate > lambda_max * (1.0 + 1e-12) || (step == 2 && estimate < 0.9 * lambda_max)) {
+                std::printf("FAIL Lipschitz step %d: estimate %.10g, largest eigenvalue %.10g\n", step, estimate,
+                    lambda_max);
+                ++failures;
+            }
+        }
+
+        // 异步求解更新的估计器经句柄取回，并回求解器后继续热启动
+        RBDSolveHandle handle = solver.SolveAsync(chain.sys);
+        handle.Join();
+        const double async_estimate = handle.GetLipschitzEstimator().GetEstimate();
+        if (async_estimate < 0.9 * lambda_max || async_estimate > lambda_max * (1.0 + 1e-12)) {
+            std::printf("FAIL Lipschitz async: estimate %.10g, largest eigenvalue %.10g\n", async_estimate, lambda_max);
+            ++failures;
+        }
+        return failures;
+    }
+
+} // namespace
+
+int main() {
+    // 异步求解只在工作线程上执行
+    RBDGetThreadPool().SetNumThreads(2);
+
+    int failures = 0;
+    failures += TestAsyncMatchesSync();
+    failures += TestCancelStopsEarly();
+    failures += TestPipelineMatchesSolve();
+    failures += TestTimeBudget();
+    failures += TestComplianceClosedForm();
+    failures += TestLipschitzEstimate();
+    if (failures == 0)
+        std::printf("solver feature checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
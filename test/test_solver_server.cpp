@@ -0,0 +1,298 @@
+﻿// 本地求解服务的端到端检查：服务在本进程的线程中运行，几个客户端线程各自经 Unix 域套接字
+// 连接，把问题写进共享内存段后流水线式提交，核对原地写回的 λ 与本地 RBDSolverAPGD 的结果
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../Wrapper/MyRBDHostVariables.h"
+#include "../Wrapper/MyRBDHostConstraint.h"
+#include "../server/RBDShmProtocol.h"
+#include "../server/RBDShmSegment.h"
+#include "../server/RBDSolverServer.h"
+#include "../solver/include/RBDSolverAPGD.h"
+#include "../solver/include/RBDStaticSystemDescriptor.h"
+
+using namespace VSLibRBDynamX;
+
+namespace {
+
+    const int MAX_ITERATIONS = 3000;
+    const double TOLERANCE = 1e-10;
+
+    /// 一个问题的原始数组：nv 个 6 自由度物体，每个物体一个摩擦接触，相邻物体之间一个双边约束
+    struct Problem {
+        std::vector<std::int32_t> dofs;
+        std::vector<double> inv_mass;
+        std::vector<RBDShmConstraintRecord> records;
+        std::vector<double> jacobian;
+        int total_dim = 0;
+        std::int32_t solver = RBD_SHM_SOLVER_APGD;
+    };
+
+    Problem MakeProblem(int nv, unsigned seed, std::int32_t solver) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+        Problem p;
+        p.solver = solver;
+        for (int i = 0; i < nv; ++i) {
+            p.dofs.push_back(6);
+            for (int d = 0; d < 6; ++d)
+                p.inv_mass.push_back(1.0 + 0.5 * dist(rng));
+        }
+        auto add = [&](std::int32_t type, int dim, int a, int b, double bias, double mu) {
+            RBDShmConstraintRecord rec;
+            rec.type = type;
+            rec.dim = dim;
+            rec.var[0] = a;
+            rec.var[1] = b;
+            rec.bias = bias;
+            rec.mu = mu;
+            rec.jacobian_index = p.jacobian.size();
+            const int cols = b < 0 ? 6 : 12;
+            for (int k = 0; k < dim * cols; ++k)
+                p.jacobian.push_back(dist(rng));
+            p.records.push_back(rec);
+            p.total_dim += dim;
+        };
+        for (int i = 0; i < nv; ++i)
+            add(static_cast<std::int32_t>(RBDProjectionType::FRICTION_CONE), 3, i, -1, -0.2 + 0.1 * dist(rng), 0.5);
+        for (int i = 0; i + 1 < nv; ++i)
+            add(static_cast<std::int32_t>(RBDProjectionType::BILATERAL), 1, i, i + 1, 0.1 * dist(rng), 0.0);
+        return p;
+    }
+
+    /// 把问题写进新建的段
+    bool WriteSegment(const Problem& p, const std::string& name, RBDShmSegment& seg) {
+        RBDShmProblemHeader layout;
+        std::memset(&layout, 0, sizeof(layout));
+        const std::uint64_t size = RBDShmComputeLayout(layout, static_cast<int>(p.dofs.size()),
+            static_cast<int>(p.records.size()), p.inv_mass.size(), p.total_dim, p.jacobian.size());
+        if (!seg.Create(name, size))
+            return false;
+        auto* h = static_cast<RBDShmProblemHeader*>(seg.GetData());
+        *h = layout;
+        h->solver = p.solver;
+        h->max_iterations = MAX_ITERATIONS;
+        h->tolerance = TOLERANCE;
+        std::memcpy(RBDShmArray<std::int32_t>(h, h->dof_offset), p.dofs.data(), p.dofs.size() * sizeof(std::int32_t));
+        std::memcpy(RBDShmArray<double>(h, h->inv_mass_offset), p.inv_mass.data(), p.inv_mass.size() * sizeof(double));
+        std::memcpy(RBDShmArray<RBDShmConstraintRecord>(h, h->constraint_offset), p.records.data(),
+            p.records.size() * sizeof(RBDShmConstraintRecord));
+        std::memcpy(RBDShmArray<double>(h, h->jacobian_offset), p.jacobian.data(), p.jacobian.size() * sizeof(double));
+        return true;
+    }
+
+    /// 本地参考解（按约束顺序的 λ 与速度）
+    void SolveLocally(const Problem& p, std::vector<double>& lambda, std::vector<double>& velocity) {
+        const int nv = static_cast<int>(p.dofs.size());
+        velocity.assign(p.inv_mass.size(), 0.0);
+        std::vector<MyRBDHostVariables> vars;
+        vars.reserve(nv);
+        for (int i = 0; i < nv; ++i)
+            vars.emplace_back(velocity.data() + 6 * i, p.inv_mass.data() + 6 * i, 6);
+        std::vector<MyRBDHostConstraint> cons;
+        cons.reserve(p.records.size());
+        RBDStaticSystemDescriptor<RBDTypeList<MyRBDHostVariables>, RBDTypeList<MyRBDHostConstraint>> sysd;
+        for (auto& v : vars)
+            sysd.Add(&v);
+        for (const auto& rec : p.records) {
+            cons.emplace_back(&vars[rec.var[0]], rec.var[1] < 0 ? nullptr : &vars[rec.var[1]], rec.dim,
+                p.jacobian.data() + rec.jacobian_index, rec.bias, static_cast<RBDProjectionType>(rec.type), rec.mu);
+            sysd.Add(&cons.back());
+        }
+
+        RBDSolverAPGD solver;
+        solver.SetMaxIterations(MAX_ITERATIONS);
+        solver.SetTolerance(TOLERANCE);
+        solver.SolveSpecialized(sysd);
+        std::vector<double> gamma;
+        solver.Dump_Lambda(gamma);
+        lambda.clear();
+        for (const auto& c : cons)
+            lambda.insert(lambda.end(), gamma.begin() + c.GetOffset(), gamma.begin() + c.GetOffset() + c.GetConstraintDim());
+    }
+
+    int Connect(const std::string& path) {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+            return fd;
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    void Send(int fd, std::uint32_t ticket, const std::string& segment, int segment_fd) {
+        RBDShmRequest request;
+        std::memset(&request, 0, sizeof(request));
+        request.magic = RBD_SHM_MAGIC;
+        request.ticket = ticket;
+        std::strncpy(request.segment, segment.c_str(), RBD_SHM_NAME_MAX - 1);
+        RBDShmSendRequest(fd, request, segment_fd);
+    }
+
+    bool Receive(int fd, RBDShmReply& reply) {
+        char* p = reinterpret_cast<char*>(&reply);
+        std::size_t left = sizeof(reply);
+        while (left > 0) {
+            const ssize_t n = recv(fd, p, left, 0);
+            if (n <= 0)
+                return false;
+            p += n;
+            left -= static_cast<std::size_t>(n);
+        }
+        return reply.magic == RBD_SHM_MAGIC;
+    }
+
+    /// 一个客户端：提交 num_problems 个问题（APGD 与 ENSEMBLE 交替）和三个非法请求，再收齐回复核对
+    int RunClient(const std::string& path, int client, int num_problems) {
+        const int fd = Connect(path);
+        if (fd < 0) {
+            std::printf("FAIL client %d: cannot connect\n", client);
+            return 1;
+        }
+
+        const std::string prefix = "/rbd_test_" + std::to_string(getpid()) + "_" + std::to_string(client) + "_";
+        std::vector<Problem> problems;
+        std::vector<RBDShmSegment> segments(num_problems);
+        for (int k = 0; k < num_problems; ++k) {
+            const std::int32_t solver = k % 2 ? RBD_SHM_SOLVER_ENSEMBLE : RBD_SHM_SOLVER_APGD;
+            problems.push_back(MakeProblem(5, 100u * client + k, solver));
+            if (!WriteSegment(problems[k], prefix + std::to_string(k), segments[k])) {
+                std::printf("FAIL client %d: cannot create segment %d\n", client, k);
+                close(fd);
+                return 1;
+            }
+        }
+
+        // 段的大小已封住：客户端自己也不能再缩小它
+        int failures = 0;
+        if (ftruncate(segments[0].GetFd(), 0) == 0) {
+            std::printf("FAIL client %d: a sealed segment could be shrunk\n", client);
+            ++failures;
+        }
+
+        // 非法请求：未附带段；变量下标越界；段的大小未封住（客户端随时可以缩小它）
+        RBDShmSegment bad;
+        Problem broken = MakeProblem(2, 1, RBD_SHM_SOLVER_APGD);
+        broken.records[0].var[0] = 7;
+        WriteSegment(broken, prefix + "bad", bad);
+        // 后者内容与第一个问题完全相同，只差封印
+        const int unsealed = memfd_create((prefix + "unsealed").c_str(), MFD_CLOEXEC);
+        const std::size_t size0 = segments[0].GetSize();
+        if (unsealed < 0 || ftruncate(unsealed, static_cast<off_t>(size0)) != 0 ||
+            pwrite(unsealed, segments[0].GetData(), size0, 0) != static_cast<ssize_t>(size0)) {
+            std::printf("FAIL client %d: cannot create the unsealed segment\n", client);
+            ++failures;
+        }
+
+        for (int k = 0; k < num_problems; ++k)
+            Send(fd, k, segments[k].GetName(), segments[k].GetFd());
+        Send(fd, 1000, prefix + "missing", -1);
+        Send(fd, 1001, bad.GetName(), bad.GetFd());
+        Send(fd, 1002, prefix + "unsealed", unsealed);
+        if (unsealed >= 0)
+            close(unsealed);
+
+        std::map<std::uint32_t, RBDShmReply> replies;
+        for (int k = 0; k < num_problems + 3; ++k) {
+            RBDShmReply reply;
+            if (!Receive(fd, reply)) {
+                std::printf("FAIL client %d: connection closed before all replies arrived\n", client);
+                ++failures;
+                break;
+            }
+            replies[reply.ticket] = reply;
+        }
+        close(fd);
+
+        if (replies.count(1000) && replies[1000].status != RBD_SHM_BAD_SEGMENT) {
+            std::printf("FAIL client %d: request without a segment was not rejected\n", client);
+            ++failures;
+        }
+        if (replies.count(1001) && replies[1001].status != RBD_SHM_BAD_PROBLEM) {
+            std::printf("FAIL client %d: invalid problem was not rejected\n", client);
+            ++failures;
+        }
+        if (replies.count(1002) && replies[1002].status != RBD_SHM_BAD_SEGMENT) {
+            std::printf("FAIL client %d: unsealed segment was not rejected\n", client);
+            ++failures;
+        }
+
+        std::vector<double> lambda, velocity;
+        for (int k = 0; k < num_problems && failures == 0; ++k) {
+            const auto it = replies.find(k);
+            auto* h = static_cast<RBDShmProblemHeader*>(segments[k].GetData());
+            if (it == replies.end() || it->second.status != RBD_SHM_OK || h->status != RBD_SHM_OK) {
+                std::printf("FAIL client %d problem %d: not solved\n", client, k);
+                ++failures;
+                continue;
+            }
+
+            // APGD 走与本地相同的代码路径，结果逐位相同；ENSEMBLE 收敛到同一解
+            SolveLocally(problems[k], lambda, velocity);
+            const double* out = RBDShmArray<double>(h, h->lambda_offset);
+            const double* vel = RBDShmArray<double>(h, h->velocity_offset);
+            const double tol = problems[k].solver == RBD_SHM_SOLVER_APGD ? 0.0 : 1e-6;
+            double err = 0.0;
+            for (std::size_t i = 0; i < lambda.size(); ++i)
+                err = std::max(err, std::fabs(out[i] - lambda[i]));
+            for (std::size_t i = 0; i < velocity.size(); ++i)
+                err = std::max(err, std::fabs(vel[i] - velocity[i]));
+            if (err > tol) {
+                std::printf("FAIL client %d problem %d: lambda/velocity differ from the local solve by %g\n",
+                    client, k, err);
+                ++failures;
+            }
+        }
+
+        return failures;
+    }
+
+} // namespace
+
+int main() {
+    const std::string path = "/tmp/rbd_test_server_" + std::to_string(getpid()) + ".sock";
+    RBDSolverServer server;
+    if (!server.Start(path)) {
+        std::printf("FAIL: cannot start the server on %s\n", path.c_str());
+        return 1;
+    }
+
+    const int num_clients = 3;
+    const int num_problems = 8;
+    std::vector<int> failures(num_clients, 0);
+    std::vector<std::thread> clients;
+    for (int c = 0; c < num_clients; ++c)
+        clients.emplace_back([&, c]() { failures[c] = RunClient(path, c, num_problems); });
+    for (auto& t : clients)
+        t.join();
+    server.Stop();
+
+    int total = 0;
+    for (int f : failures)
+        total += f;
+    if (server.GetNumSolved() != num_clients * num_problems) {
+        std::printf("FAIL: server solved %lld problems, expected %d\n", server.GetNumSolved(),
+            num_clients * num_problems);
+        ++total;
+    }
+    if (total == 0)
+        std::printf("%d clients x %d problems solved in %lld batches, lambda written back in place\n",
+            num_clients, num_problems, server.GetNumBatches());
+    return total == 0 ? 0 : 1;
+}
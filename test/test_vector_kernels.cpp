@@ -0,0 +1,222 @@
+﻿// 检查各指令集级别的向量内核与标量实现在舍入误差范围内一致
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "../solver/include/RBDVectorKernels.h"
+#include "../solver/include/RBDBodyMassBatch.h"
+#include "../RBDInterface/RBDConstraintContact.h"
+
+using namespace VSLibRBDynamX;
+
+namespace {
+
+    int g_failures = 0;
+
+    void Check(const char* what, RBDSimdLevel level, int n, double value, double reference) {
+        const double tol = 1e-12 * (1.0 + std::fabs(reference)) * (1.0 + n);
+        if (!(std::fabs(value - reference) <= tol)) {
+            std::printf("FAIL %-18s %-7s n=%-5d %.17g vs %.17g\n",
+                what, RBDSimdLevelName(level), n, value, reference);
+            ++g_failures;
+        }
+    }
+
+    void CheckVector(const char* what, RBDSimdLevel level, const std::vector<double>& value,
+        const std::vector<double>& reference) {
+        for (std::size_t i = 0; i < value.size(); ++i)
+            Check(what, level, static_cast<int>(value.size()), value[i], reference[i]);
+    }
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    auto random_vector = [&](int n) {
+        std::vector<double> v(n);
+        for (auto& e : v)
+            e = dist(rng);
+        return v;
+    };
+
+    const RBDVectorKernels& S = RBDGetVectorKernels(RBDSimdLevel::SCALAR);
+    const RBDSimdLevel hw = RBDDetectSimdLevel();
+    std::printf("detected SIMD level: %s\n", RBDSimdLevelName(hw));
+
+    const int sizes[] = { 0, 1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 1000, 1003 };
+    for (int n : sizes) {
+        const auto x = random_vector(n), y = random_vector(n), g = random_vector(n), r = random_vector(n);
+
+        for (int l = static_cast<int>(RBDSimdLevel::SCALAR); l <= static_cast<int>(hw); ++l) {
+            const RBDSimdLevel level = static_cast<RBDSimdLevel>(l);
+            const RBDVectorKernels& K = RBDGetVectorKernels(level);
+            if (K.level != level) {
+                std::printf("FAIL table for %s reports %s\n", RBDSimdLevelName(level), RBDSimdLevelName(K.level));
+                ++g_failures;
+            }
+
+            Check("Dot", level, n, K.Dot(n, x.data(), y.data()), S.Dot(n, x.data(), y.data()));
+            Check("Norm", level, n, K.Norm(n, x.data()), S.Norm(n, x.data()));
+            Check("DistSquared", level, n, K.DistSquared(n, x.data(), y.data()), S.DistSquared(n, x.data(), y.data()));
+
+            auto a = y, b = y;
+            K.Axpy(n, 0.37, x.data(), a.data());
+            S.Axpy(n, 0.37, x.data(), b.data());
+            CheckVector("Axpy", level, a, b);
+
+            K.Waxpy(n, a.data(), x.data(), -1.25, y.data());
+            S.Waxpy(n, b.data(), x.data(), -1.25, y.data());
+            CheckVector("Waxpy", level, a, b);
+
+            a = g;
+            b = g;
+            Check("GradientObjective", level, n,
+                K.GradientObjective(n, a.data(), r.data(), y.data()),
+                S.GradientObjective(n, b.data(), r.data(), y.data()));
+            CheckVector("GradientObjective", level, a, b);
+
+            std::vector<double> yk(n), ys(n);
+            for (int clamp = 0; clamp < 2; ++clamp) {
+                K.ProjectedWaxpy(n, clamp != 0, a.data(), x.data(), -0.8, y.data());
+                S.ProjectedWaxpy(n, clamp != 0, b.data(), x.data(), -0.8, y.data());
+                CheckVector("ProjectedWaxpy", level, a, b);
+            }
+
+            for (int mode = 0; mode < 3; ++mode) {
+                double fk[6], fs[6];
+                std::vector<double> pk(n), ps(n);
+                K.FusedUpdate(n, mode, x.data(), y.data(), g.data(), r.data(), a.data(), y.data(), 0.3, 1e-3,
+                    yk.data(), pk.data(), fk);
+                S.FusedUpdate(n, mode, x.data(), y.data(), g.data(), r.data(), a.data(), y.data(), 0.3, 1e-3,
+                    ys.data(), ps.data(), fs);
+                CheckVector("FusedUpdate", level, yk, ys);
+                if (mode == 2)
+                    CheckVector("FusedUpdate", level, pk, ps);
+                for (int k = 0; k < 6; ++k)
+                    Check("FusedUpdate", level, n, fk[k], fs[k]);
+            }
+
+            // 摩擦锥：随机点覆盖锥内、极锥内和锥外三种情形，另加 μ = 0 与 ||λt|| = 0 的边界
+            std::vector<double> mu(n), cn = x, c1 = y, c2 = g;
+            for (int k = 0; k < n; ++k) {
+                mu[k] = k % 5 == 0 ? 0.0 : 0.5 * (r[k] + 1.0);
+                if (k % 7 == 3)
+                    c1[k] = c2[k] = 0.0;
+            }
+            auto rn = cn, r1 = c1, r2 = c2;
+            for (int k = 0; k < n; ++k)
+                RBDProjectFrictionCone(mu[k], rn[k], r1[k], r2[k]);
+            K.ProjectFrictionCone(n, mu.data(), cn.data(), c1.data(), c2.data());
+            CheckVector("ProjectFrictionCone", level, cn, rn);
+            CheckVector("ProjectFrictionCone", level, c1, r1);
+            CheckVector("ProjectFrictionCone", level, c2, r2);
+        }
+    }
+
+    // 通道内核：[行][通道] 交错，通道数覆盖不足一个寄存器、整寄存器与带余数的情形
+    const int rows = 7;
+    const int lane_counts[] = { 1, 3, 4, 8, 13, 16 };
+    for (int lanes : lane_counts) {
+        const int n = rows * lanes;
+        const auto x = random_vector(n), y = random_vector(n), g = random_vector(n), r = random_vector(n);
+        const auto coef = random_vector(lanes);
+
+        // 每行 0~3 个非零元素的 CSR（第 0 行为空）
+        std::vector<int> ptr(1, 0), col;
+        for (int i = 0; i < rows; ++i) {
+            for (int k = 0; k < i % 4; ++k)
+                col.push_back((3 * i + 5 * k) % rows);
+            ptr.push_back(static_cast<int>(col.size()));
+        }
+        const auto vals = random_vector(static_cast<int>(col.size()) * lanes);
+
+        for (int l = static_cast<int>(RBDSimdLevel::SCALAR); l <= static_cast<int>(hw); ++l) {
+            const RBDSimdLevel level = static_cast<RBDSimdLevel>(l);
+            const RBDVectorKernels& K = RBDGetVectorKernels(level);
+
+            std::vector<double> a(n, 9.0), b(n, -9.0);
+            K.LaneCsrMultiply(rows, lanes, ptr.data(), col.data(), vals.data(), x.data(), a.data());
+            S.LaneCsrMultiply(rows, lanes, ptr.data(), col.data(), vals.data(), x.data(), b.data());
+            CheckVector("LaneCsrMultiply", level, a, b);
+
+            K.LaneWaxpy(rows, lanes, a.data(), x.data(), coef.data(), y.data());
+            S.LaneWaxpy(rows, lanes, b.data(), x.data(), coef.data(), y.data());
+            CheckVector("LaneWaxpy", level, a, b);
+
+            std::vector<double> ok(3 * lanes), os(3 * lanes);
+            a = g;
+            b = g;
+            K.LaneGradientObjective(rows, lanes, a.data(), r.data(), y.data(), ok.data());
+            S.LaneGradientObjective(rows, lanes, b.data(), r.data(), y.data(), os.data());
+            CheckVector("LaneGradientObjective", level, a, b);
+            CheckVector("LaneGradientObjective", level, ok, os);
+
+            K.LaneBacktrackTerms(rows, lanes, x.data(), y.data(), g.data(), r.data(), a.data(), ok.data());
+            S.LaneBacktrackTerms(rows, lanes, x.data(), y.data(), g.data(), r.data(), a.data(), os.data());
+            CheckVector("LaneBacktrackTerms", level, ok, os);
+
+            std::vector<double> yk(n), ys(n);
+            K.LaneExtrapolate(rows, lanes, x.data(), y.data(), coef.data(), g.data(), yk.data(), ok.data());
+            S.LaneExtrapolate(rows, lanes, x.data(), y.data(), coef.data(), g.data(), ys.data(), os.data());
+            CheckVector("LaneExtrapolate", level, yk, ys);
+            for (int k = 0; k < 2 * lanes; ++k)
+                Check("LaneExtrapolate", level, n, ok[k], os[k]);
+
+            K.LaneDistSquared(rows, lanes, x.data(), y.data(), ok.data());
+            S.LaneDistSquared(rows, lanes, x.data(), y.data(), os.data());
+            for (int k = 0; k < lanes; ++k)
+                Check("LaneDistSquared", level, n, ok[k], os[k]);
+        }
+    }
+
+    // 刚体质量逆批量：各级别与逐个刚体的 ComputeMassInverseTimesVector 逐位相同（都不用 FMA、运算顺序相同）。
+    // 刚体数覆盖不足一个寄存器、带余数以及跨越多个并行块的情形；偏移之间留空隙，检查 gather / scatter
+    const int body_counts[] = { 1, 3, 4, 5, 8, 9, 13, 17, 1031 };
+    for (int nb : body_counts) {
+        const int stride = 7;
+        std::vector<RBDVariablesBody> bodies(nb);
+        for (int i = 0; i < nb; ++i) {
+            bodies[i].SetOffset(stride * i);
+            bodies[i].SetBodyMass(i % 11 == 0 ? 0.0 : 1.5 + dist(rng));
+            std::array<double, 9> I;
+            for (auto& e : I)
+                e = dist(rng);
+            bodies[i].SetBodyInvInertia(I);
+        }
+        const auto f = random_vector(stride * nb);
+
+        // 参考：逐个刚体的虚接口，空隙中的元素保持不变
+        std::vector<double> reference = f;
+        for (int i = 0; i < nb; ++i) {
+            std::vector<double> fi(f.begin() + stride * i, f.begin() + stride * i + 6), ri;
+            bodies[i].ComputeMassInverseTimesVector(fi, ri);
+            std::copy(ri.begin(), ri.end(), reference.begin() + stride * i);
+        }
+
+        RBDBodyMassBatch batch;
+        for (const auto& b : bodies)
+            batch.Add(&b);
+        for (int l = static_cast<int>(RBDSimdLevel::SCALAR); l <= static_cast<int>(hw); ++l) {
+            const RBDSimdLevel level = static_cast<RBDSimdLevel>(l);
+            RBDSetSimdLevel(level);
+            std::vector<double> v = f;
+            batch.Apply(v.data());
+            if (v.size() != reference.size() ||
+                std::memcmp(v.data(), reference.data(), v.size() * sizeof(double)) != 0) {
+                std::printf("FAIL %-18s %-7s n=%-5d not bitwise identical to the per-body computation\n",
+                    "BodyMassBatch", RBDSimdLevelName(level), nb);
+                ++g_failures;
+            }
+        }
+        RBDSetSimdLevel(hw);
+    }
+
+    if (g_failures == 0)
+        std::printf("all SIMD kernel paths agree with the scalar reference\n");
+    return g_failures == 0 ? 0 : 1;
+}